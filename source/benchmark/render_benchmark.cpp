@@ -0,0 +1,254 @@
+// Headless BoardRenderer benchmark. Renders synthetic boards into an
+// offscreen framebuffer and prints the timings as JSON on stdout, e.g.
+//   QT_QPA_PLATFORM=offscreen ./render_benchmark --frames 20
+// Mesa's software rasterizer is used unless --hardware is given, so results
+// are comparable between machines without a GPU.
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QGuiApplication>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLFramebufferObject>
+#include <QOpenGLFunctions>
+#include <QOpenGLTimerQuery>
+#include <QSurfaceFormat>
+#include <algorithm>
+#include <array>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "game_logic/coordinates.hpp"
+#include "game_logic/game_board.hpp"
+#include "game_logic/random_source.hpp"
+#include "graphics_engine/asset_loader.hpp"
+#include "graphics_engine/board_renderer.hpp"
+#include "graphics_engine/board_resources.hpp"
+#include "graphics_engine/camera.hpp"
+#include "graphics_engine/render_queue.hpp"
+
+namespace {
+
+constexpr int kViewSize = 1024;
+constexpr int kWarmupFrames = 3;
+constexpr std::array<int, 5> kBoardSizes = {9, 32, 128, 512, 1024};
+constexpr std::array<double, 4> kMovingFractions = {0.0, 0.01, 0.1, 1.0};
+constexpr uint64_t kSeed = 1;
+
+typedef struct {
+  double cpu_update_us;
+  double cpu_submit_us;
+  double uploaded_bytes;
+  double gpu_us;
+} FrameTimes;
+
+class RenderBenchmark {
+ public:
+  RenderBenchmark(QOpenGLContext &context, int frames)
+      : _context(context), _frames(frames) {}
+
+  bool Init() {
+    _gl = _context.functions();
+    _fbo = std::make_unique<QOpenGLFramebufferObject>(kViewSize, kViewSize);
+    _fbo->bind();
+    _gl->glViewport(0, 0, kViewSize, kViewSize);
+
+    _assets.Start(BoardResources::ImagePaths(),
+                  BoardResources::ShaderPaths());
+    _queue.Init();
+    _resources.Init(_assets, _queue);
+    _renderer.Init(_resources, 0);
+    _renderer.SetProjection(QMatrix4x4());
+    _camera.SetViewport(kViewSize, kViewSize);
+
+    // GL_TIME_ELAPSED queries are not available on every driver
+    _gpu_timer_available = _gpu_timer.create();
+    return _fbo->isValid();
+  }
+
+  QJsonObject Run(int board_size, double moving_fraction,
+                  BoardRenderer::RenderPath render_path) {
+    GameBoard board(board_size, board_size, kSeed);
+    RandomSource random(kSeed);
+    std::vector<Coordinates> moving;
+    for (int x = 0; x < board_size; x++) {
+      for (int y = 0; y < board_size; y++) {
+        if (random.UniformUnit() <= moving_fraction) {
+          moving.push_back({x, y});
+        }
+      }
+    }
+
+    _camera.FitBoard(board_size, board_size);
+    _renderer.SetRenderPath(render_path);
+
+    FrameTimes total = {0.0, 0.0, 0.0, 0.0};
+    for (int frame = -kWarmupFrames; frame < _frames; frame++) {
+      // every moving tile moves each frame, as it would while animating
+      float offset = (frame + kWarmupFrames + 1) / 16.0f;
+      for (const auto &pos : moving) {
+        board.SetTileOffset(pos.x, pos.y, 0.0f, offset);
+      }
+
+      FrameTimes times = RenderFrame(board);
+      if (frame >= 0) {
+        total.cpu_update_us += times.cpu_update_us;
+        total.cpu_submit_us += times.cpu_submit_us;
+        total.uploaded_bytes += times.uploaded_bytes;
+        total.gpu_us += times.gpu_us;
+      }
+    }
+
+    QJsonObject result;
+    result["board_size"] = board_size;
+    result["moving_fraction"] = moving_fraction;
+    result["moving_tiles"] = static_cast<int>(moving.size());
+    result["render_path"] =
+        render_path == BoardRenderer::kChunked ? "chunked" : "type_map";
+    result["frames"] = _frames;
+    result["cpu_update_us"] = total.cpu_update_us / _frames;
+    result["cpu_submit_us"] = total.cpu_submit_us / _frames;
+    result["uploaded_bytes"] = total.uploaded_bytes / _frames;
+    if (_gpu_timer_available) {
+      result["gpu_us"] = total.gpu_us / _frames;
+    } else {
+      result["gpu_us"] = QJsonValue::Null;
+    }
+    return result;
+  }
+
+  bool gpu_timer_available() const { return _gpu_timer_available; }
+
+ private:
+  FrameTimes RenderFrame(const GameBoard &board) {
+    FrameTimes times = {0.0, 0.0, 0.0, 0.0};
+    quint64 uploaded_before = _renderer.uploaded_bytes();
+    if (_gpu_timer_available) {
+      _gpu_timer.begin();
+    }
+
+    _gl->glClear(GL_COLOR_BUFFER_BIT);
+    // rebuilding and uploading the board data
+    QElapsedTimer clock;
+    clock.start();
+    _renderer.Update(board, _camera);
+    _renderer.RenderStatic(_queue);
+    _renderer.RenderDynamic(board, _camera, _queue);
+    times.cpu_update_us = clock.nsecsElapsed() / 1000.0;
+
+    // issuing the draws
+    clock.restart();
+    _queue.Flush();
+    times.cpu_submit_us = clock.nsecsElapsed() / 1000.0;
+
+    if (_gpu_timer_available) {
+      _gpu_timer.end();
+      times.gpu_us = _gpu_timer.waitForResult() / 1000.0;
+    }
+    _gl->glFinish();
+    times.uploaded_bytes = _renderer.uploaded_bytes() - uploaded_before;
+    return times;
+  }
+
+  QOpenGLContext &_context;
+  QOpenGLFunctions *_gl;
+  int _frames;
+  std::unique_ptr<QOpenGLFramebufferObject> _fbo;
+  AssetLoader _assets;
+  RenderQueue _queue;
+  BoardResources _resources;
+  BoardRenderer _renderer;
+  Camera _camera;
+  QOpenGLTimerQuery _gpu_timer;
+  bool _gpu_timer_available;
+};
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  // must be decided before the first context is created
+  bool hardware = false;
+  for (int i = 1; i < argc; i++) {
+    hardware |= QByteArray(argv[i]) == "--hardware";
+  }
+  if (!hardware) {
+    qputenv("LIBGL_ALWAYS_SOFTWARE", "1");
+  }
+
+  QGuiApplication app(argc, argv);
+  setlocale(LC_NUMERIC, "C");
+  QCommandLineParser parser;
+  parser.addHelpOption();
+  parser.setApplicationDescription("Tux Match BoardRenderer benchmark");
+  QCommandLineOption frames_option("frames", "measured frames per case",
+                                   "frames", "20");
+  parser.addOption(frames_option);
+  QCommandLineOption hardware_option("hardware",
+                                     "use the GPU instead of Mesa llvmpipe");
+  parser.addOption(hardware_option);
+  QCommandLineOption max_size_option("max-size", "largest board size to run",
+                                     "size", "1024");
+  parser.addOption(max_size_option);
+  parser.process(app);
+  int frames = std::max(1, parser.value(frames_option).toInt());
+  int max_size = parser.value(max_size_option).toInt();
+
+  // same versions as the game, see main.cpp
+  QSurfaceFormat format;
+  if (QOpenGLContext::openGLModuleType() == QOpenGLContext::LibGL) {
+    format.setVersion(4, 1);
+  } else {
+    format.setRenderableType(QSurfaceFormat::OpenGLES);
+    format.setVersion(3, 0);
+  }
+  format.setProfile(QSurfaceFormat::CoreProfile);
+  QSurfaceFormat::setDefaultFormat(format);
+
+  QOffscreenSurface surface;
+  surface.setFormat(format);
+  surface.create();
+  QOpenGLContext context;
+  context.setFormat(format);
+  if (!context.create() || !context.makeCurrent(&surface)) {
+    std::cerr << "could not create an offscreen GL context" << std::endl;
+    return 1;
+  }
+
+  RenderBenchmark benchmark(context, frames);
+  if (!benchmark.Init()) {
+    std::cerr << "could not create the framebuffer" << std::endl;
+    return 1;
+  }
+
+  QJsonArray results;
+  for (int board_size : kBoardSizes) {
+    if (board_size > max_size) {
+      continue;
+    }
+    for (double moving_fraction : kMovingFractions) {
+      for (auto render_path : {BoardRenderer::kChunked,
+                               BoardRenderer::kTypeMap}) {
+        results.append(
+            benchmark.Run(board_size, moving_fraction, render_path));
+      }
+    }
+  }
+
+  QOpenGLFunctions *gl = context.functions();
+  QJsonObject report;
+  report["benchmark"] = "board_renderer";
+  report["gl_renderer"] = reinterpret_cast<const char *>(
+      gl->glGetString(GL_RENDERER));
+  report["gl_version"] =
+      reinterpret_cast<const char *>(gl->glGetString(GL_VERSION));
+  report["gpu_timer"] = benchmark.gpu_timer_available();
+  report["view_size"] = kViewSize;
+  report["results"] = results;
+  // object keys are sorted, so the output diffs cleanly between runs
+  std::cout << QJsonDocument(report).toJson(QJsonDocument::Indented)
+                   .toStdString();
+  return 0;
+}
@@ -0,0 +1,138 @@
+#include "blob_labeler.hpp"
+
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
+
+BlobLabeler::BlobLabeler() : _height(0) {}
+
+void BlobLabeler::Label(const std::vector<uint8_t> &types, int width,
+                        int height, WorkerPool &pool, int strip_count) {
+  int tile_count = width * height;
+  _height = height;
+  _parent.resize(tile_count);
+  _root_labels.resize(tile_count);
+  _labels.resize(tile_count);
+
+  strip_count = std::clamp(strip_count, 1, std::max(width, 1));
+  _strips.resize(strip_count);
+  for (int i = 0; i < strip_count; i++) {
+    _strips[i].begin = (width * i) / strip_count;
+    _strips[i].end = (width * (i + 1)) / strip_count;
+  }
+
+  // label every strip on its own, each only touches its own columns
+  pool.ParallelFor(strip_count,
+                   [&](int strip) { LabelStrip(types, _strips[strip]); });
+
+  // merge the blobs that continue over the strip boundaries
+  for (int strip = 1; strip < strip_count; strip++) {
+    int x = _strips[strip].begin;
+    for (int y = 0; y < height; y++) {
+      int index = x * height + y;
+      if (types[index] == types[index - height]) {
+        Union(index, index - height);
+      }
+    }
+  }
+
+  // number the roots, a root always lies in the strip of its lowest index so
+  // every strip can hand out its own range of labels
+  _strip_label_offsets.assign(strip_count + 1, 0);
+  pool.ParallelFor(strip_count, [&](int strip) {
+    int roots = 0;
+    int end = _strips[strip].end * height;
+    for (int i = _strips[strip].begin * height; i < end; i++) {
+      if (_parent[i] == i) {
+        ++roots;
+      }
+    }
+    _strip_label_offsets[strip + 1] = roots;
+  });
+  for (int strip = 0; strip < strip_count; strip++) {
+    _strip_label_offsets[strip + 1] += _strip_label_offsets[strip];
+  }
+  pool.ParallelFor(strip_count, [&](int strip) {
+    int label = _strip_label_offsets[strip];
+    int end = _strips[strip].end * height;
+    for (int i = _strips[strip].begin * height; i < end; i++) {
+      if (_parent[i] == i) {
+        _root_labels[i] = label++;
+      }
+    }
+  });
+
+  // Assign labels and count them. Labels owned by the strip are counted in
+  // the shared histogram directly, labels of blobs rooted in an earlier strip
+  // go to a partial histogram of the strip that is merged afterwards.
+  _histogram.assign(_strip_label_offsets[strip_count], 0);
+  _strip_foreign_counts.resize(strip_count);
+  if (static_cast<int>(_strip_arenas.size()) < strip_count) {
+    _strip_arenas.resize(strip_count);
+  }
+  pool.ParallelFor(strip_count, [&](int strip) {
+    int label_begin = _strip_label_offsets[strip];
+    FrameArena &arena = _strip_arenas[strip];
+    arena.Reset();
+    std::pmr::unordered_map<int, int> foreign_counts(arena.resource());
+    int end = _strips[strip].end * height;
+    for (int i = _strips[strip].begin * height; i < end; i++) {
+      int label = _root_labels[Find(i)];
+      _labels[i] = label;
+      if (label >= label_begin) {
+        _histogram[label]++;
+      } else {
+        foreign_counts[label]++;
+      }
+    }
+    _strip_foreign_counts[strip].assign(foreign_counts.begin(),
+                                        foreign_counts.end());
+  });
+  for (const auto &foreign_counts : _strip_foreign_counts) {
+    for (const auto &count : foreign_counts) {
+      _histogram[count.first] += count.second;
+    }
+  }
+}
+
+int BlobLabeler::Find(int index) const {
+  while (_parent[index] != index) {
+    index = _parent[index];
+  }
+  return index;
+}
+
+int BlobLabeler::FindAndCompress(int index) {
+  int root = Find(index);
+  while (_parent[index] != root) {
+    int next = _parent[index];
+    _parent[index] = root;
+    index = next;
+  }
+  return root;
+}
+
+void BlobLabeler::Union(int a, int b) {
+  int root_a = FindAndCompress(a);
+  int root_b = FindAndCompress(b);
+  if (root_a < root_b) {
+    _parent[root_b] = root_a;
+  } else if (root_b < root_a) {
+    _parent[root_a] = root_b;
+  }
+}
+
+void BlobLabeler::LabelStrip(const std::vector<uint8_t> &types, Strip strip) {
+  for (int x = strip.begin; x < strip.end; x++) {
+    for (int y = 0; y < _height; y++) {
+      int index = x * _height + y;
+      _parent[index] = index;
+      if (y > 0 && types[index] == types[index - 1]) {
+        Union(index, index - 1);
+      }
+      if (x > strip.begin && types[index] == types[index - _height]) {
+        Union(index, index - _height);
+      }
+    }
+  }
+}
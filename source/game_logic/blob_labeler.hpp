@@ -0,0 +1,48 @@
+#ifndef SOURCE_GAME_LOGIC_BLOB_LABELER_HPP_
+#define SOURCE_GAME_LOGIC_BLOB_LABELER_HPP_
+
+#include <cstdint>
+#include <vector>
+
+#include "frame_arena.hpp"
+#include "worker_pool.hpp"
+
+// Labels 4-connected blobs of equal piece types on a column major type grid.
+// The board is split into column strips that are labeled independently with
+// union-find on the worker pool, after which the equivalences across the
+// strip boundaries are merged. Labels are compact, starting at 0.
+class BlobLabeler {
+ public:
+  BlobLabeler();
+
+  void Label(const std::vector<uint8_t> &types, int width, int height,
+             WorkerPool &pool, int strip_count);
+
+  const std::vector<int> &labels() const { return _labels; }
+  const std::vector<int> &histogram() const { return _histogram; }
+
+ private:
+  typedef struct {
+    int begin;
+    int end;
+  } Strip;
+
+  int Find(int index) const;
+  int FindAndCompress(int index);
+  void Union(int a, int b);
+  void LabelStrip(const std::vector<uint8_t> &types, Strip strip);
+
+  int _height;
+  std::vector<Strip> _strips;
+  // union-find forest over tile indices, roots are the lowest index of a blob
+  std::vector<int> _parent;
+  std::vector<int> _root_labels;
+  std::vector<int> _strip_label_offsets;
+  std::vector<std::vector<std::pair<int, int>>> _strip_foreign_counts;
+  // scratch per strip, only grows so the arenas stay warm
+  std::vector<FrameArena> _strip_arenas;
+  std::vector<int> _labels;
+  std::vector<int> _histogram;
+};
+
+#endif  // SOURCE_GAME_LOGIC_BLOB_LABELER_HPP_
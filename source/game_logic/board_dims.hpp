@@ -0,0 +1,38 @@
+#ifndef SOURCE_GAME_LOGIC_BOARD_DIMS_HPP_
+#define SOURCE_GAME_LOGIC_BOARD_DIMS_HPP_
+
+#include <array>
+
+// Dimensions of a column major board with a one tile border. The board loops
+// are templated on these, FixedBoardDims turns the sizes and neighbour offsets
+// into compile time constants so loops over common board sizes unroll and
+// vectorize, RuntimeBoardDims covers all other sizes.
+// Neighbour offsets are ordered left, below, right, above.
+struct RuntimeBoardDims {
+  RuntimeBoardDims() : RuntimeBoardDims(0, 0) {}
+  RuntimeBoardDims(int width, int height)
+      : width(width),
+        height(height),
+        stride(height + 2),
+        neighbour_offsets({{-stride, -1, stride, 1}}) {}
+
+  int Index(int x, int y) const { return (x + 1) * stride + y + 1; }
+
+  int width;
+  int height;
+  int stride;
+  std::array<int, 4> neighbour_offsets;
+};
+
+template <int Width, int Height>
+struct FixedBoardDims {
+  static constexpr int Index(int x, int y) { return (x + 1) * stride + y + 1; }
+
+  static constexpr int width = Width;
+  static constexpr int height = Height;
+  static constexpr int stride = Height + 2;
+  static constexpr std::array<int, 4> neighbour_offsets = {
+      {-stride, -1, stride, 1}};
+};
+
+#endif  // SOURCE_GAME_LOGIC_BOARD_DIMS_HPP_
@@ -0,0 +1,183 @@
+#include "board_generator.hpp"
+
+#include <array>
+#include <cstddef>
+#include <utility>
+
+BoardGenerator::BoardGenerator(int type_count, int blob_threshold)
+    : _type_count(type_count), _blob_threshold(blob_threshold) {}
+
+std::vector<uint8_t> BoardGenerator::Generate(int width, int height,
+                                              int min_moves,
+                                              RandomSource &random) {
+  std::vector<uint8_t> types(width * height);
+  FillWithoutBlobs(types, width, height, random);
+
+  // random boards without blobs nearly always have plenty of moves, plant
+  // extra ones for the rare board that does not
+  int attempts = min_moves * kPlantAttemptsPerMove;
+  while (CountMoves(types, width, height, min_moves) < min_moves &&
+         attempts > 0) {
+    while (attempts > 0 && !PlantMove(types, width, height, random)) {
+      --attempts;
+    }
+  }
+  return types;
+}
+
+int BoardGenerator::CountMoves(std::vector<uint8_t> &types, int width,
+                               int height, int limit) const {
+  int moves = 0;
+  for (int x = 0; x < width && moves < limit; x++) {
+    for (int y = 0; y < height && moves < limit; y++) {
+      int index = x * height + y;
+      // swaps with the right and the upper neighbour
+      std::array<int, 2> neighbours = {{x < width - 1 ? index + height : -1,
+                                        y < height - 1 ? index + 1 : -1}};
+      for (int neighbour : neighbours) {
+        if (neighbour < 0 || types[index] == types[neighbour]) {
+          continue;
+        }
+        std::swap(types[index], types[neighbour]);
+        if (BlobSize(types, width, height, index, _blob_threshold) >=
+                _blob_threshold ||
+            BlobSize(types, width, height, neighbour, _blob_threshold) >=
+                _blob_threshold) {
+          ++moves;
+        }
+        std::swap(types[index], types[neighbour]);
+      }
+    }
+  }
+  return moves;
+}
+
+int BoardGenerator::Find(int index) {
+  while (_parent[index] != index) {
+    _parent[index] = _parent[_parent[index]];
+    index = _parent[index];
+  }
+  return index;
+}
+
+void BoardGenerator::FillWithoutBlobs(std::vector<uint8_t> &types, int width,
+                                      int height, RandomSource &random) {
+  // Place tiles in order, only picking types that keep the blob they join
+  // with their left and lower neighbour below the threshold. That excludes
+  // at most two types per tile.
+  _parent.resize(width * height);
+  _size.resize(width * height);
+  std::vector<uint8_t> allowed(_type_count);
+  for (int x = 0; x < width; x++) {
+    for (int y = 0; y < height; y++) {
+      int index = x * height + y;
+      int left_root = x > 0 ? Find(index - height) : -1;
+      int below_root = y > 0 ? Find(index - 1) : -1;
+
+      int allowed_count = 0;
+      for (int type = 0; type < _type_count; type++) {
+        int size = 1;
+        if (left_root >= 0 && types[index - height] == type) {
+          size += _size[left_root];
+        }
+        if (below_root >= 0 && below_root != left_root &&
+            types[index - 1] == type) {
+          size += _size[below_root];
+        }
+        if (size < _blob_threshold) {
+          allowed[allowed_count++] = type;
+        }
+      }
+      uint8_t type = allowed_count > 0
+                         ? allowed[random.Uniform(allowed_count)]
+                         : random.Uniform(_type_count);
+      types[index] = type;
+
+      _parent[index] = index;
+      _size[index] = 1;
+      for (int root : {left_root, below_root}) {
+        int neighbour = root == left_root ? index - height : index - 1;
+        if (root < 0 || types[neighbour] != type) {
+          continue;
+        }
+        int own_root = Find(index);
+        root = Find(root);
+        if (root != own_root) {
+          _parent[own_root] = root;
+          _size[root] += _size[own_root];
+        }
+      }
+    }
+  }
+}
+
+bool BoardGenerator::PlantMove(std::vector<uint8_t> &types, int width,
+                               int height, RandomSource &random) const {
+  // A row of threshold - 1 equal tiles, with a matching tile diagonally above
+  // the next position in the row. Swapping that tile down completes the row.
+  int row_length = _blob_threshold - 1;
+  if (width < row_length + 1 || height < 2) {
+    return false;
+  }
+  int x = random.Uniform(width - row_length);
+  int y = random.Uniform(height - 1);
+  uint8_t type = random.Uniform(_type_count);
+
+  std::vector<std::pair<int, uint8_t>> changed;
+  auto set_type = [&](int index, uint8_t new_type) {
+    changed.push_back({index, types[index]});
+    types[index] = new_type;
+  };
+  for (int i = 0; i < row_length; i++) {
+    set_type((x + i) * height + y, type);
+  }
+  int gap = (x + row_length) * height + y;
+  if (types[gap] == type) {
+    set_type(gap, (type + 1) % _type_count);
+  }
+  set_type(gap + 1, type);
+
+  // undo when the planted tiles formed a blob already
+  for (const auto &change : changed) {
+    if (BlobSize(types, width, height, change.first, _blob_threshold) >=
+        _blob_threshold) {
+      for (auto it = changed.rbegin(); it != changed.rend(); ++it) {
+        types[it->first] = it->second;
+      }
+      return false;
+    }
+  }
+  return true;
+}
+
+int BoardGenerator::BlobSize(std::vector<uint8_t> &types, int width,
+                             int height, int start, int limit) const {
+  // flood fill that stops at limit tiles, visited tiles are marked in place
+  // and restored before returning
+  uint8_t type = types[start];
+  _fill.clear();
+  _fill.push_back(start);
+  types[start] = kVisited;
+  for (std::size_t i = 0; i < _fill.size(); i++) {
+    int index = _fill[i];
+    int x = index / height;
+    int y = index % height;
+    std::array<int, 4> neighbours = {
+        {x > 0 ? index - height : -1, x < width - 1 ? index + height : -1,
+         y > 0 ? index - 1 : -1, y < height - 1 ? index + 1 : -1}};
+    for (int neighbour : neighbours) {
+      if (static_cast<int>(_fill.size()) >= limit) {
+        break;
+      }
+      if (neighbour >= 0 && types[neighbour] == type) {
+        types[neighbour] = kVisited;
+        _fill.push_back(neighbour);
+      }
+    }
+  }
+
+  for (int index : _fill) {
+    types[index] = type;
+  }
+  return _fill.size();
+}
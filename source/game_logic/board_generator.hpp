@@ -0,0 +1,43 @@
+#ifndef SOURCE_GAME_LOGIC_BOARD_GENERATOR_HPP_
+#define SOURCE_GAME_LOGIC_BOARD_GENERATOR_HPP_
+
+#include <cstdint>
+#include <vector>
+
+#include "random_source.hpp"
+
+// Generates column major piece type grids without any blob of blob_threshold
+// or more tiles, that still offer at least min_moves valid moves. Runs in
+// linear time in the number of tiles and only touches its own state, so it
+// can run on a worker.
+class BoardGenerator {
+ public:
+  BoardGenerator(int type_count, int blob_threshold);
+
+  std::vector<uint8_t> Generate(int width, int height, int min_moves,
+                                RandomSource &random);
+  // counts valid moves on a board without blobs, stops counting at limit
+  int CountMoves(std::vector<uint8_t> &types, int width, int height,
+                 int limit) const;
+
+ private:
+  int Find(int index);
+  void FillWithoutBlobs(std::vector<uint8_t> &types, int width, int height,
+                        RandomSource &random);
+  bool PlantMove(std::vector<uint8_t> &types, int width, int height,
+                 RandomSource &random) const;
+  int BlobSize(std::vector<uint8_t> &types, int width, int height, int start,
+               int limit) const;
+
+  static constexpr uint8_t kVisited = 0xFF;
+  static constexpr int kPlantAttemptsPerMove = 64;
+
+  int _type_count;
+  int _blob_threshold;
+  // union-find over the tiles placed so far, sizes are valid at the roots
+  std::vector<int> _parent;
+  std::vector<int> _size;
+  mutable std::vector<int> _fill;
+};
+
+#endif  // SOURCE_GAME_LOGIC_BOARD_GENERATOR_HPP_
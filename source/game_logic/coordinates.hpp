@@ -18,7 +18,7 @@ class CoordinatesF {
   CoordinatesF(float x, float y) : x(x), y(y) {}
   bool operator==(const CoordinatesF& b) const { return x == b.x && y == b.y; }
   bool operator!=(const CoordinatesF& b) const { return x != b.x || y != b.y; }
-  operator Coordinates() { return {static_cast<int>(x), static_cast<int>(y)}; }
+  operator Coordinates() const { return {static_cast<int>(x), static_cast<int>(y)}; }
 
   float x;
   float y;
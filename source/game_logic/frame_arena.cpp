@@ -0,0 +1,114 @@
+#include "frame_arena.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+FrameArena::FrameArena(std::size_t capacity)
+    : _capacity(capacity),
+      _upstream(std::make_unique<Upstream>()),
+      _buffer(std::make_unique<std::byte[]>(capacity)),
+      _resource(std::make_unique<std::pmr::monotonic_buffer_resource>(
+          _buffer.get(), capacity, _upstream.get())) {}
+
+void FrameArena::Reset() {
+  if (_upstream->bytes() == 0) {
+    // starts over at the beginning of the buffer
+    _resource->release();
+    return;
+  }
+
+  // the previous use did not fit, grow to everything it took
+  _capacity += _upstream->bytes();
+  _resource.reset();
+  _upstream->ResetBytes();
+  _buffer = std::make_unique<std::byte[]>(_capacity);
+  _resource = std::make_unique<std::pmr::monotonic_buffer_resource>(
+      _buffer.get(), _capacity, _upstream.get());
+}
+
+void *FrameArena::Upstream::do_allocate(std::size_t bytes,
+                                        std::size_t alignment) {
+  _bytes += bytes;
+  return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+}
+
+void FrameArena::Upstream::do_deallocate(void *memory, std::size_t bytes,
+                                         std::size_t alignment) {
+  std::pmr::new_delete_resource()->deallocate(memory, bytes, alignment);
+}
+
+bool FrameArena::Upstream::do_is_equal(
+    const std::pmr::memory_resource &other) const noexcept {
+  return this == &other;
+}
+
+#ifdef TUX_MATCH_COUNT_ALLOCATIONS
+
+namespace {
+std::atomic<uint64_t> allocation_count(0);
+
+void *CountedAllocate(std::size_t size) {
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  void *memory = std::malloc(size != 0 ? size : 1);
+  if (memory == nullptr) {
+    throw std::bad_alloc();
+  }
+  return memory;
+}
+
+void *CountedAllocate(std::size_t size, std::align_val_t alignment) {
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  // aligned_alloc wants a multiple of the alignment
+  std::size_t align = static_cast<std::size_t>(alignment);
+  std::size_t rounded = (std::max<std::size_t>(size, 1) + align - 1) /
+                        align * align;
+  void *memory = std::aligned_alloc(align, rounded);
+  if (memory == nullptr) {
+    throw std::bad_alloc();
+  }
+  return memory;
+}
+}  // namespace
+
+void *operator new(std::size_t size) { return CountedAllocate(size); }
+void *operator new[](std::size_t size) { return CountedAllocate(size); }
+void *operator new(std::size_t size, std::align_val_t alignment) {
+  return CountedAllocate(size, alignment);
+}
+void *operator new[](std::size_t size, std::align_val_t alignment) {
+  return CountedAllocate(size, alignment);
+}
+void operator delete(void *memory) noexcept { std::free(memory); }
+void operator delete[](void *memory) noexcept { std::free(memory); }
+void operator delete(void *memory, std::size_t) noexcept { std::free(memory); }
+void operator delete[](void *memory, std::size_t) noexcept {
+  std::free(memory);
+}
+void operator delete(void *memory, std::align_val_t) noexcept {
+  std::free(memory);
+}
+void operator delete[](void *memory, std::align_val_t) noexcept {
+  std::free(memory);
+}
+void operator delete(void *memory, std::size_t, std::align_val_t) noexcept {
+  std::free(memory);
+}
+void operator delete[](void *memory, std::size_t, std::align_val_t) noexcept {
+  std::free(memory);
+}
+
+bool AllocationCounter::Enabled() { return true; }
+
+uint64_t AllocationCounter::Count() {
+  return allocation_count.load(std::memory_order_relaxed);
+}
+
+#else
+
+bool AllocationCounter::Enabled() { return false; }
+
+uint64_t AllocationCounter::Count() { return 0; }
+
+#endif  // TUX_MATCH_COUNT_ALLOCATIONS
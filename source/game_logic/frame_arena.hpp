@@ -0,0 +1,63 @@
+#ifndef SOURCE_GAME_LOGIC_FRAME_ARENA_HPP_
+#define SOURCE_GAME_LOGIC_FRAME_ARENA_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+
+// Monotonic scratch memory for std::pmr containers that only live for one
+// frame or one move. Reset frees everything at once. Memory needed past the
+// buffer comes from the heap, the next Reset grows the buffer to fit it, so
+// once warm a steady workload does not touch the heap. Not thread safe, use
+// one arena per thread.
+class FrameArena {
+ public:
+  explicit FrameArena(std::size_t capacity = kDefaultCapacity);
+
+  std::pmr::memory_resource *resource() { return _resource.get(); }
+  // invalidates everything allocated since the previous Reset
+  void Reset();
+
+  std::size_t capacity() const { return _capacity; }
+  // bytes taken from the heap since the previous Reset
+  std::size_t overflow_bytes() const { return _upstream->bytes(); }
+
+  static constexpr std::size_t kDefaultCapacity = 16 << 10;
+
+ private:
+  // counts what the arena takes from the heap once the buffer is used up
+  class Upstream : public std::pmr::memory_resource {
+   public:
+    Upstream() : _bytes(0) {}
+    std::size_t bytes() const { return _bytes; }
+    void ResetBytes() { _bytes = 0; }
+
+   private:
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void do_deallocate(void *memory, std::size_t bytes,
+                       std::size_t alignment) override;
+    bool do_is_equal(
+        const std::pmr::memory_resource &other) const noexcept override;
+
+    std::size_t _bytes;
+  };
+
+  std::size_t _capacity;
+  // held by pointer, so arenas can be moved
+  std::unique_ptr<Upstream> _upstream;
+  std::unique_ptr<std::byte[]> _buffer;
+  std::unique_ptr<std::pmr::monotonic_buffer_resource> _resource;
+};
+
+// Counts heap allocations of the whole program when built with
+// TUX_MATCH_COUNT_ALLOCATIONS, which replaces the global operator new. Used to
+// check that steady frames do not allocate.
+class AllocationCounter {
+ public:
+  static bool Enabled();
+  // allocations since program start, 0 when not enabled
+  static uint64_t Count();
+};
+
+#endif  // SOURCE_GAME_LOGIC_FRAME_ARENA_HPP_
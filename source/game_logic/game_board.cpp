@@ -2,161 +2,521 @@
 
 #include <algorithm>
 #include <array>
+#include <cassert>
+#include <cmath>
 #include <iostream>
+#include <unordered_set>
 #include <utility>
 
-GameBoard::GameBoard(int width, int height)
-    : _random_generator(),
+#include "level_pack.hpp"
+#include "worker_pool.hpp"
+
+GameBoard::GameBoard(int width, int height, uint64_t seed)
+    : _dims(width, height),
+      _parallel_labeling_threshold(kDefaultParallelLabelingThreshold),
+      _random(seed),
       _board_width(width),
       _board_height(height),
-      _board_tiles_changed(true) {
+      _version(0),
+      _deletion_version(0),
+      _region_stamp(0),
+      _board_tiles_changed(true),
+      _tick(0),
+      _change_stamp(0) {
   Create(width, height);
 }
 
 GameBoard::~GameBoard() { ; }
 
-void GameBoard::DragStart(CoordinatesF pos) {
-  _drag_start_pos = ClampToBoard(pos);
-  TileAt(_drag_start_pos).animation = kStationary;
+void GameBoard::DragStart(CoordinatesF pos, int pointer) {
+  CoordinatesF start_pos = ClampToBoard(pos);
+  _drag_starts[pointer] = start_pos;
+  TileAt(start_pos).set_animation(kStationary);
+  Animate(Index(start_pos));
+  if (pointer == kMousePointer) {
+    StartSpeculation(start_pos);
+  }
 }
 
-void GameBoard::DragMove(CoordinatesF pos) {
+void GameBoard::DragMove(CoordinatesF pos, int pointer) {
+  auto drag = _drag_starts.find(pointer);
+  if (drag == _drag_starts.end()) {
+    return;
+  }
+  CoordinatesF start_pos = drag->second;
   CoordinatesF clamped_pos = ClampToBoard(pos);
 
+  // the board changed under the drag, speculate again
+  if (pointer == kMousePointer &&
+      !_move_speculator.Matches(start_pos, _version)) {
+    StartSpeculation(start_pos);
+  }
+
   // limit dragging to 4 connected neigbours, by an arbitrary algorithm
-  float delta_x = clamped_pos.x - _drag_start_pos.x;
-  float delta_y = clamped_pos.y - _drag_start_pos.y;
+  float delta_x = clamped_pos.x - start_pos.x;
+  float delta_y = clamped_pos.y - start_pos.y;
   float delta_total = fabs(delta_x) + fabs(delta_y);
   float delta_factor = std::max(1.0f, delta_total - 0.2f);
   delta_x = std::clamp(delta_x / delta_factor, -1.0f, 1.0f);
   delta_y = std::clamp(delta_y / delta_factor, -1.0f, 1.0f);
 
   // assign dragging offset
-  BoardTile &tile = TileAt(_drag_start_pos);
-  tile.offset_x = delta_x;
-  tile.offset_y = delta_y;
+  BoardTile &tile = TileAt(start_pos);
+  tile.set_offset_x(delta_x);
+  tile.set_offset_y(delta_y);
+  Animate(Index(start_pos));
 
   // see if evading should happen
-  if (fabs(tile.offset_x) > kEvadeThreshold ||
-      fabs(tile.offset_y) > kEvadeThreshold) {
-    EvadeTile();
+  if (fabs(tile.offset_x()) > kEvadeThreshold ||
+      fabs(tile.offset_y()) > kEvadeThreshold) {
+    EvadeTile(start_pos);
   } else {
-    EvadeCancel(_drag_start_pos);
+    EvadeCancel(start_pos);
   }
 }
 
-int GameBoard::DragReleaseAndCheckMove(CoordinatesF pos) {
-  EvadeCancel(_drag_start_pos);
+int GameBoard::DragReleaseAndCheckMove(CoordinatesF pos, int pointer) {
+  if (pointer != kMousePointer) {
+    return DragReleaseAndCheckMoves({{pointer, pos}}).front();
+  }
+  auto drag = _drag_starts.find(pointer);
+  if (drag == _drag_starts.end()) {
+    return 0;
+  }
+  CoordinatesF start_pos = drag->second;
+  _drag_starts.erase(drag);
+  _move_arena.Reset();
+
+  EvadeCancel(start_pos);
   CoordinatesF clamped_pos = ClampToBoard(pos);
-  Coordinates source_tile = _drag_start_pos;
-  Coordinates destination_tile = source_tile;
+  Coordinates source_tile = start_pos;
+  Coordinates destination_tile =
+      DragDestination(start_pos, clamped_pos.x - start_pos.x,
+                      clamped_pos.y - start_pos.y);
 
-  // determine destination tile
-  float delta_x = clamped_pos.x - _drag_start_pos.x;
-  float delta_y = clamped_pos.y - _drag_start_pos.y;
-  if (fabs(delta_x) > fabs(delta_y)) {
-    if (delta_x > 0.1f) {
-      destination_tile.x++;
-    } else if (delta_x < -0.1f) {
-      destination_tile.x--;
+  // commit the speculated result if the board did not change since, otherwise
+  // check and execute move. Drags from the edge can point past it, those
+  // never score.
+  int score = 0;
+  bool overlaps = false;
+  if (OnBoard(destination_tile)) {
+    overlaps = Deleting();
+    const MoveSpeculator::MoveResult *result = nullptr;
+    if (_move_speculator.Matches(source_tile, _version)) {
+      result = _move_speculator.Result(destination_tile);
     }
-  } else {
-    if (delta_y > 0.1f) {
-      destination_tile.y++;
-    } else if (delta_y < -0.1f) {
-      destination_tile.y--;
+    if (result) {
+      score = result->score;
+      if (score != 0) {
+        SwapTile(source_tile, destination_tile);
+        MarkTilesForDeletion(result->deletions);
+      }
+    } else {
+      score = ExecuteMove(source_tile, destination_tile);
     }
   }
+  if (score != 0) {
+    JournalSwap(source_tile, destination_tile, score, overlaps);
+  }
+  _move_speculator.Cancel();
 
-  // check and execute move
-  int score = ExecuteMove(_drag_start_pos, destination_tile);
   if (score == 0) {
-    _board[_drag_start_pos.x][_drag_start_pos.y].animation = kReturn;
+    _tiles[Index(source_tile)].set_animation(kReturn);
+    Animate(Index(source_tile));
   }
 
   return score;
 }
 
+std::pmr::vector<int> GameBoard::DragReleaseAndCheckMoves(
+    const std::vector<Release> &releases) {
+  _move_arena.Reset();
+  std::pmr::vector<int> scores(releases.size(), 0, _move_arena.resource());
+  if (_swap_results.size() < releases.size()) {
+    _swap_results.resize(releases.size());
+  }
+  int swap_count = 0;
+  for (int i = 0; i < static_cast<int>(releases.size()); i++) {
+    auto drag = _drag_starts.find(releases[i].pointer);
+    if (drag == _drag_starts.end()) {
+      continue;
+    }
+    CoordinatesF start_pos = drag->second;
+    _drag_starts.erase(drag);
+    if (releases[i].pointer == kMousePointer) {
+      _move_speculator.Cancel();
+    }
+
+    EvadeCancel(start_pos);
+    CoordinatesF clamped_pos = ClampToBoard(releases[i].pos);
+    SwapResult &result = _swap_results[swap_count++];
+    result.release = i;
+    result.source = start_pos;
+    result.destination =
+        DragDestination(start_pos, clamped_pos.x - start_pos.x,
+                        clamped_pos.y - start_pos.y);
+  }
+
+  // every swap is evaluated on the board as it is, without the others
+  WorkerPool::Global().ParallelFor(
+      swap_count, [this](int i) { EvaluateSwap(&_swap_results[i]); });
+
+  // Swaps are applied in release order. A swap whose region overlaps the
+  // region of an earlier one may depend on it, it is evaluated again on the
+  // board with the earlier swaps applied.
+  if (_region_stamps.size() != _tiles.size() || ++_region_stamp == 0) {
+    _region_stamps.assign(_tiles.size(), 0);
+    _region_stamp = 1;
+  }
+  bool deletions_started = false;
+  bool deleting = Deleting();
+  for (int i = 0; i < swap_count; i++) {
+    SwapResult &result = _swap_results[i];
+    bool overlaps = std::any_of(
+        result.region.begin(), result.region.end(),
+        [this](int index) { return _region_stamps[index] == _region_stamp; });
+    if (overlaps) {
+      EvaluateSwap(&result);
+    }
+    for (int index : result.region) {
+      _region_stamps[index] = _region_stamp;
+    }
+
+    scores[result.release] = result.score;
+    if (result.score == 0) {
+      _tiles[Index(result.source)].set_animation(kReturn);
+      Animate(Index(result.source));
+      continue;
+    }
+    SwapTile(result.source, result.destination);
+    if (!deletions_started) {
+      StartDeletions();
+      deletions_started = true;
+    }
+    for (int index : result.deletions) {
+      _tiles[index].set_animation(kDelete);
+      Animate(index);
+      _deletions.push_back(
+          {index / _dims.stride - 1, index % _dims.stride - 1});
+    }
+    // the swaps after it overlap its deletions
+    JournalSwap(result.source, result.destination, result.score, deleting);
+    deleting = true;
+  }
+  return scores;
+}
+
+int GameBoard::DragPreviewScore() const {
+  auto drag = _drag_starts.find(kMousePointer);
+  if (drag == _drag_starts.end() ||
+      !_move_speculator.Matches(drag->second, _version)) {
+    return -1;
+  }
+
+  CoordinatesF start_pos = drag->second;
+  const BoardTile &tile = _tiles[Index(start_pos)];
+  const MoveSpeculator::MoveResult *result = _move_speculator.TryResult(
+      DragDestination(start_pos, tile.offset_x(), tile.offset_y()));
+  return result ? result->score : -1;
+}
+
 void GameBoard::PhysicsTick() {
-  bool deletes_done = false;
-  for (auto &column : _board) {
-    column.resize(_board_height);
-    for (auto &piece : column) {
-      switch (piece.animation) {
-        case kStationary: {
-          break;
-        }
-        case kReturn: {
-          piece.offset_x *= kReturnSpeed;
-          piece.offset_y *= kReturnSpeed;
-
-          if (fabs(piece.offset_x) < kStationaryThreshold &&
-              fabs(piece.offset_y) < kStationaryThreshold) {
-            piece.offset_x = 0.0f;
-            piece.offset_y = 0.0f;
-            piece.animation = kStationary;
-          }
-          break;
-        }
-        case kFall: {
-          std::uniform_int_distribution<> random_distribution(0, 1000);
-          if (random_distribution(_random_generator) == 1) {
-            piece.offset_y = _board_height + 1;
-          }
-          piece.offset_y -= kFallSpeed;
-          break;
-        }
-        case kDelete:
-        case kDeleteDone: {
-          piece.offset_x += 0.2f;
-          if (piece.offset_x > kDeleteThreshold) {
-            piece.animation = kDeleteDone;
-            deletes_done = true;
-          }
-          break;
-          case kEvadeUp:
-            piece.offset_y = std::max(piece.offset_y - 0.1f, -1.0f);
-            break;
-          case kEvadeDown:
-            piece.offset_y = std::min(piece.offset_y + 0.1f, 1.0f);
-            break;
-          case kEvadeLeft:
-            piece.offset_x = std::max(piece.offset_x - 0.1f, -1.0f);
-            break;
-          case kEvadeRight:
-            piece.offset_x = std::min(piece.offset_x + 0.1f, 1.0f);
-            break;
+  ++_tick;
+  StepAnimations();
+  CompleteAnimations();
+}
+
+bool GameBoard::UndoMove(int *score) {
+  if (!Settled()) {
+    return false;
+  }
+  // the journal starts with a swap that does not overlap, so stepping back
+  // always ends on one
+  MoveJournal::Record &record = _journal_record;
+  *score = 0;
+  while (_journal.StepBack(&record)) {
+    if (record.kind == MoveJournal::kReplenish) {
+      RevertReplenish(record);
+      continue;
+    }
+    ApplySwap(record);
+    *score += record.score;
+    if (!record.overlaps) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool GameBoard::RedoMove(int *score) {
+  MoveJournal::Kind kind;
+  bool overlaps;
+  if (!Settled() || !_journal.PeekForward(&kind, &overlaps)) {
+    return false;
+  }
+  MoveJournal::Record &record = _journal_record;
+  _journal.StepForward(&record);
+  ApplySwap(record);
+  *score = record.score;
+  // the replenishes and overlapping moves up to the next move
+  while (_journal.PeekForward(&kind, &overlaps) &&
+         (kind == MoveJournal::kReplenish || overlaps)) {
+    _journal.StepForward(&record);
+    if (kind == MoveJournal::kReplenish) {
+      ApplyReplenish(record);
+    } else {
+      ApplySwap(record);
+      *score += record.score;
+    }
+  }
+  return true;
+}
+
+template <typename Function>
+void GameBoard::DispatchDims(Function &&function) {
+  if (_board_width == _board_height) {
+    switch (_board_width) {
+      case 9:
+        return function(FixedBoardDims<9, 9>());
+      case 12:
+        return function(FixedBoardDims<12, 12>());
+      case 15:
+        return function(FixedBoardDims<15, 15>());
+      case 18:
+        return function(FixedBoardDims<18, 18>());
+      case 21:
+        return function(FixedBoardDims<21, 21>());
+    }
+  }
+  function(_dims);
+}
+
+void GameBoard::StepAnimations() {
+  // tiles animated since the last tick join in column major order
+  if (!_newly_animated.empty()) {
+    std::sort(_newly_animated.begin(), _newly_animated.end());
+    _animated_merge.resize(_animated.size() + _newly_animated.size());
+    std::merge(_animated.begin(), _animated.end(), _newly_animated.begin(),
+               _newly_animated.end(), _animated_merge.begin());
+    std::swap(_animated, _animated_merge);
+    _newly_animated.clear();
+  }
+
+  size_t kept = 0;
+  for (size_t i = 0; i < _animated.size(); i++) {
+    int index = _animated[i];
+    BoardTile &piece = _tiles[index];
+    if (piece.animation() == kStationary && !piece.moving()) {
+      _animated_flags[index] = 0;
+      continue;
+    }
+    _animated[kept++] = index;
+    if (piece.animation() != kStationary) {
+      MarkChanged(index);
+    }
+    switch (piece.animation()) {
+      case kStationary: {
+        break;
+      }
+      case kReturn: {
+        piece.set_offset_x(piece.offset_x() * kReturnSpeed);
+        piece.set_offset_y(piece.offset_y() * kReturnSpeed);
+        break;
+      }
+      case kFall: {
+        int &fall_restart_countdown = _fall_restart_countdown[index];
+        float offset_y = piece.offset_y();
+        if (fall_restart_countdown == 0) {
+          offset_y = _board_height + 1;
+          fall_restart_countdown = _random.Geometric(kFallRestartChance);
+        } else {
+          --fall_restart_countdown;
         }
+        piece.set_offset_y(offset_y - kFallSpeed);
+        break;
+      }
+      case kDelete:
+      case kDeleteDone: {
+        piece.set_offset_x(piece.offset_x() + kDeleteSpeed);
+        break;
       }
+      case kEvadeUp:
+        piece.set_offset_y(std::max(piece.offset_y() - 0.1f, -1.0f));
+        break;
+      case kEvadeDown:
+        piece.set_offset_y(std::min(piece.offset_y() + 0.1f, 1.0f));
+        break;
+      case kEvadeLeft:
+        piece.set_offset_x(std::max(piece.offset_x() - 0.1f, -1.0f));
+        break;
+      case kEvadeRight:
+        piece.set_offset_x(std::min(piece.offset_x() + 0.1f, 1.0f));
+        break;
     }
   }
-  if (deletes_done) {
+  _animated.resize(kept);
+}
+
+void GameBoard::CompleteAnimations() {
+  _fired_completions.clear();
+  _completions.Advance(_tick, &_fired_completions);
+  _completed_deletions.clear();
+  for (const TimingWheel::Event &event : _fired_completions) {
+    if (event.stamp != _completion_stamps[event.key]) {
+      continue;
+    }
+    BoardTile &piece = _tiles[event.key];
+    MarkChanged(event.key);
+    if (piece.animation() == kReturn) {
+      piece.fixed_offset_x = 0;
+      piece.fixed_offset_y = 0;
+      piece.set_animation(kStationary);
+    } else if (piece.animation() == kDelete) {
+      piece.set_animation(kDeleteDone);
+      _completed_deletions.push_back(event.key);
+    }
+  }
+  if (!_completed_deletions.empty()) {
+    std::sort(_completed_deletions.begin(), _completed_deletions.end());
     DeleteAndReplenish();
   }
 }
 
+void GameBoard::Animate(int index) {
+  BoardTile &piece = _tiles[index];
+  // the border is never animated
+  if (piece.type() == kNone) {
+    return;
+  }
+  MarkChanged(index);
+  uint32_t stamp = ++_completion_stamps[index];
+  int ticks = TicksToComplete(piece);
+  if (ticks > 0) {
+    _completions.Schedule({_tick + ticks, index, stamp});
+  }
+  if (!_animated_flags[index] &&
+      (piece.animation() != kStationary || piece.moving())) {
+    _animated_flags[index] = 1;
+    _newly_animated.push_back(index);
+  }
+}
+
+void GameBoard::MarkChanged(int index) {
+  Coordinates pos = Position(index);
+  _change_stamps[pos.x / kChangeChunkSize * ChangeChunkRows() +
+                 pos.y / kChangeChunkSize] = ++_change_stamp;
+}
+
+int GameBoard::TicksToComplete(BoardTile tile) {
+  // steps a copy like StepAnimations, so the completion falls on the same tick
+  // the offsets cross the threshold
+  int ticks = 0;
+  if (tile.animation() == kReturn) {
+    while (true) {
+      ++ticks;
+      float offset_x = tile.offset_x() * kReturnSpeed;
+      float offset_y = tile.offset_y() * kReturnSpeed;
+      if (fabs(offset_x) < kStationaryThreshold &&
+          fabs(offset_y) < kStationaryThreshold) {
+        break;
+      }
+      tile.set_offset_x(offset_x);
+      tile.set_offset_y(offset_y);
+    }
+  } else if (tile.animation() == kDelete) {
+    do {
+      ++ticks;
+      tile.set_offset_x(tile.offset_x() + kDeleteSpeed);
+    } while (!(tile.offset_x() > kDeleteThreshold));
+  }
+  return ticks;
+}
+
+void GameBoard::SetTileOffset(int x, int y, float offset_x, float offset_y) {
+  BoardTile &tile = _tiles[Index(x, y)];
+  tile.set_offset_x(offset_x);
+  tile.set_offset_y(offset_y);
+  Animate(Index(x, y));
+}
+
 void GameBoard::Create(int width, int height) {
-  _board_width = width;
-  _board_height = height;
-  std::uniform_int_distribution<> random_distribution(kTux, kWildebeest);
+  Create(width, height, GenerateTypes(width, height, DrawSeed()));
+}
+
+void GameBoard::Create(int width, int height,
+                       const std::vector<uint8_t> &types) {
+  Reset(width, height);
+  int tile_index = 0;
+  for (int x = 0; x < _board_width; x++) {
+    for (int y = 0; y < _board_height; y++) {
+      _tiles[Index(x, y)] = MakeTile(
+          static_cast<PieceType>(types[tile_index++]), kReturn, height);
+      Animate(Index(x, y));
+    }
+  }
+}
 
-  _board.resize(_board_width);
-  for (auto &column : _board) {
-    column.resize(_board_height);
-    for (auto &piece : column) {
-      piece.type =
-          static_cast<PieceType>(random_distribution(_random_generator));
-      piece.offset_x = 0;
-      piece.offset_y = height;
-      piece.animation = kReturn;
+void GameBoard::CreatePacked(int width, int height, const uint8_t *grid) {
+  Reset(width, height);
+  int tile_index = 0;
+  for (int x = 0; x < _board_width; x++) {
+    for (int y = 0; y < _board_height; y++) {
+      PieceType type =
+          static_cast<PieceType>(LevelPack::TypeAt(grid, tile_index++));
+      _tiles[Index(x, y)] = MakeTile(type, kReturn, height);
+      Animate(Index(x, y));
     }
   }
 }
 
+void GameBoard::Reset(int width, int height) {
+  _board_width = width;
+  _board_height = height;
+  ++_version;
+  _journal.Clear();
+
+  _dims = RuntimeBoardDims(_board_width, _board_height);
+  _tiles.assign((_board_width + 2) * _dims.stride,
+                MakeTile(kNone, kStationary, 0.0f));
+  _fall_restart_countdown.assign(_tiles.size(), 0);
+  _completions.Clear();
+  _completion_stamps.assign(_tiles.size(), 0);
+  _animated.clear();
+  _newly_animated.clear();
+  _animated_flags.assign(_tiles.size(), 0);
+  // every chunk differs from what views drew of the previous board
+  int chunk_columns = (_board_width + kChangeChunkSize - 1) / kChangeChunkSize;
+  _change_stamps.assign(chunk_columns * ChangeChunkRows(), ++_change_stamp);
+}
+
+std::vector<uint8_t> GameBoard::GenerateTypes(int width, int height,
+                                              uint64_t seed) {
+  RandomSource random(seed);
+  BoardGenerator generator(kPieceTypeCount, kBlobThreshold);
+  return generator.Generate(width, height, kMinGeneratedMoves, random);
+}
+
+int GameBoard::CalibrateGoal(const std::vector<uint8_t> &types, int width,
+                             int height, uint64_t seed,
+                             const GoalCalibrator::Options &options) {
+  GoalCalibrator calibrator(kPieceTypeCount, kBlobThreshold);
+  return calibrator.Calibrate(types, width, height, seed, options,
+                              WorkerPool::Global());
+}
+
+uint64_t GameBoard::DrawSeed() {
+  uint64_t high = _random.Next();
+  return high << 32 | _random.Next();
+}
+
 void GameBoard::Clear() {
-  for (auto &column : _board) {
-    for (auto &piece : column) {
-      piece.animation = kFall;
+  // draw when every tile restarts its fall up front, instead of every tick
+  for (int x = 0; x < _board_width; x++) {
+    for (int y = 0; y < _board_height; y++) {
+      int index = Index(x, y);
+      _tiles[index].set_animation(kFall);
+      _fall_restart_countdown[index] = _random.Geometric(kFallRestartChance);
+      Animate(index);
     }
   }
 }
@@ -168,17 +528,17 @@ CoordinatesF GameBoard::ClampToBoard(CoordinatesF pos) {
 }
 
 GameBoard::BoardTile &GameBoard::TileAt(CoordinatesF pos) {
-  return _board.at(static_cast<int>(pos.x)).at(static_cast<int>(pos.y));
+  return _tiles[Index(pos)];
 }
 
-void GameBoard::EvadeTile() {
-  BoardTile &tile = TileAt(_drag_start_pos);
+void GameBoard::EvadeTile(CoordinatesF start_pos) {
+  BoardTile &tile = TileAt(start_pos);
   Animation evade_animation;
-  CoordinatesF evading_tile = _drag_start_pos;
+  CoordinatesF evading_tile = start_pos;
 
   // evade to the direction from which the dragged tile came
-  if (fabs(tile.offset_x) > fabs(tile.offset_y)) {
-    if (tile.offset_x > 0) {
+  if (fabs(tile.offset_x()) > fabs(tile.offset_y())) {
+    if (tile.offset_x() > 0) {
       evade_animation = kEvadeLeft;
       evading_tile.x++;
     } else {
@@ -186,7 +546,7 @@ void GameBoard::EvadeTile() {
       evading_tile.x--;
     }
   } else {
-    if (tile.offset_y > 0) {
+    if (tile.offset_y() > 0) {
       evade_animation = kEvadeUp;
       evading_tile.y++;
     } else {
@@ -195,80 +555,177 @@ void GameBoard::EvadeTile() {
     }
   }
   // reset other tiles
-  EvadeCancel(_drag_start_pos);
+  EvadeCancel(start_pos);
 
-  TileAt(evading_tile).animation = evade_animation;
+  TileAt(evading_tile).set_animation(evade_animation);
+  Animate(Index(evading_tile));
 }
 
 void GameBoard::EvadeCancel(Coordinates pos) {
-  if (pos.x >= 1) {
-    _board[pos.x - 1][pos.y].animation = kReturn;
+  // border tiles are never animated, resetting them is harmless
+  int index = Index(pos);
+  for (int offset : _dims.neighbour_offsets) {
+    _tiles[index + offset].set_animation(kReturn);
+    Animate(index + offset);
   }
-  if (pos.x < _board_width - 1) {
-    _board[pos.x + 1][pos.y].animation = kReturn;
-  }
-  if (pos.y >= 1) {
-    _board[pos.x][pos.y - 1].animation = kReturn;
+}
+
+Coordinates GameBoard::DragDestination(Coordinates source, float delta_x,
+                                       float delta_y) const {
+  Coordinates destination = source;
+  if (fabs(delta_x) > fabs(delta_y)) {
+    if (delta_x > 0.1f) {
+      destination.x++;
+    } else if (delta_x < -0.1f) {
+      destination.x--;
+    }
+  } else {
+    if (delta_y > 0.1f) {
+      destination.y++;
+    } else if (delta_y < -0.1f) {
+      destination.y--;
+    }
   }
-  if (pos.y < _board_height - 1) {
-    _board[pos.x][pos.y + 1].animation = kReturn;
+  return destination;
+}
+
+void GameBoard::StartSpeculation(Coordinates source) {
+  std::vector<uint8_t> types(_board_width * _board_height);
+  for (int x = 0; x < _board_width; x++) {
+    const BoardTile *column = &_tiles[Index(x, 0)];
+    for (int y = 0; y < _board_height; y++) {
+      types[x * _board_height + y] = column[y].type();
+    }
   }
+  _move_speculator.Start(std::move(types), _board_width, _board_height,
+                         source, _version, kBlobThreshold);
 }
 
 void GameBoard::SwapTile(Coordinates source, Coordinates destination) {
+  ++_version;
   int delta_x = source.x - destination.x;
   int delta_y = source.y - destination.y;
-  _board[source.x][source.y].offset_x += delta_x;
-  _board[source.x][source.y].offset_y += delta_y;
-  _board[destination.x][destination.y].offset_x -= delta_x;
-  _board[destination.x][destination.y].offset_y -= delta_y;
-  std::swap(_board[source.x][source.y], _board[destination.x][destination.y]);
+  BoardTile &source_tile = _tiles[Index(source)];
+  BoardTile &destination_tile = _tiles[Index(destination)];
+  source_tile.set_offset_x(source_tile.offset_x() + delta_x);
+  source_tile.set_offset_y(source_tile.offset_y() + delta_y);
+  destination_tile.set_offset_x(destination_tile.offset_x() - delta_x);
+  destination_tile.set_offset_y(destination_tile.offset_y() - delta_y);
+  std::swap(source_tile, destination_tile);
+  Animate(Index(source));
+  Animate(Index(destination));
+}
+
+void GameBoard::JournalSwap(Coordinates source, Coordinates destination,
+                            int score, bool overlaps) {
+  MoveJournal::Record &record = _journal_record;
+  record.kind = MoveJournal::kSwap;
+  record.source = source.x * _board_height + source.y;
+  record.destination = destination.x * _board_height + destination.y;
+  record.score = score;
+  record.overlaps = overlaps;
+  _journal.Append(record);
 }
 
 void GameBoard::DeleteAndReplenish() {
-  std::uniform_int_distribution<> random_distribution(kTux, kWildebeest);
-  BoardTile new_tile = {0, 0, kTux, kReturn, 0};
+  ++_version;
+  // the journal keeps what is deleted and drawn, to revert it later
+  MoveJournal::Record &record = _journal_record;
+  record.kind = MoveJournal::kReplenish;
+  record.deleted.clear();
+  record.deleted_types.clear();
+  for (int index : _completed_deletions) {
+    int x = index / _dims.stride - 1;
+    int y = index % _dims.stride - 1;
+    record.deleted.push_back(x * _board_height + y);
+    record.deleted_types.push_back(_tiles[index].type());
+  }
+  int deletion_count = record.deleted.size();
+  record.random_before = _random.position();
+  _type_buffer.resize(deletion_count);
+  _random.FillTypes(_type_buffer.data(), deletion_count, kPieceTypeCount);
+  record.random_after = _random.position();
+  record.replacement_types = _type_buffer;
+  _journal.Append(record);
+  int next_type = 0;
+
+  // dragged tiles and the tiles that are off their place return to it, all
+  // others already are
+  auto return_tile = [this](int index) {
+    BoardTile &piece = _tiles[index];
+    if (piece.animation() != kDelete && piece.animation() != kDeleteDone) {
+      piece.set_animation(kReturn);
+      Animate(index);
+    }
+  };
+  for (const auto &drag : _drag_starts) {
+    return_tile(Index(drag.second));
+  }
+  for (size_t i = 0; i < _animated.size() + _newly_animated.size(); i++) {
+    return_tile(i < _animated.size() ? _animated[i]
+                                     : _newly_animated[i - _animated.size()]);
+  }
 
-  for (auto &column : _board) {
+  // compact the columns with deletions downwards from their first deletion,
+  // and refill them from the top
+  size_t next = 0;
+  while (next < _completed_deletions.size()) {
+    int first = _completed_deletions[next];
+    int x = first / _dims.stride - 1;
+    BoardTile *column = &_tiles[Index(x, 0)];
     int colum_deletion_count = 0;
-    for (auto piece_it = column.begin(); piece_it != column.end();) {
-      if (piece_it->animation == kDeleteDone) {
+    for (int y = first % _dims.stride - 1; y < _board_height; y++) {
+      BoardTile &piece = column[y];
+      if (piece.animation() == kDeleteDone) {
         ++colum_deletion_count;
-
-        piece_it = column.erase(piece_it);
-        new_tile.type =
-            static_cast<PieceType>(random_distribution(_random_generator));
-        column.push_back(new_tile);
-      } else {
-        if (piece_it->animation != kDelete) {
-          piece_it->offset_y += colum_deletion_count;
-          piece_it->animation = kReturn;
-        }
-        piece_it++;
+        continue;
+      }
+      if (piece.animation() != kDelete) {
+        piece.set_offset_y(piece.offset_y() + colum_deletion_count);
+        piece.set_animation(kReturn);
       }
+      column[y - colum_deletion_count] = piece;
+      Animate(Index(x, y - colum_deletion_count));
     }
+    // new tiles fall in from above the board
+    for (int y = _board_height - colum_deletion_count; y < _board_height; y++) {
+      column[y] = MakeTile(static_cast<PieceType>(_type_buffer[next_type++]),
+                           kReturn, colum_deletion_count);
+      Animate(Index(x, y));
+    }
+    next += colum_deletion_count;
   }
 }
 
 int GameBoard::ExecuteMove(Coordinates source, Coordinates destination) {
+  // a tile swapped with the border would be labeled as no blob at all
+  assert(OnBoard(source) && OnBoard(destination));
+  if (!OnBoard(source) || !OnBoard(destination)) {
+    return 0;
+  }
   // preemptively swap tiles to check if the new possittion is valid
-  std::swap(_board[source.x][source.y], _board[destination.x][destination.y]);
+  BoardTile &source_tile = _tiles[Index(source)];
+  BoardTile &destination_tile = _tiles[Index(destination)];
+  std::swap(source_tile, destination_tile);
   LabelBlobs();
-  std::swap(_board[source.x][source.y], _board[destination.x][destination.y]);
+  std::swap(source_tile, destination_tile);
 
-  // see if this move results in any large enough blobs to be a valid move
+  // see if this move results in any large enough blobs to be a valid move,
+  // labels belong to the positions the tiles were swapped to
   int score = 0;
-  int source_blob = _board[source.x][source.y].blob_label;
-  int destination_blob = _board[destination.x][destination.y].blob_label;
+  int source_blob = _blob_labels[Index(destination)];
+  int destination_blob = _blob_labels[Index(source)];
 
-  std::set<int> delete_labels;
+  std::pmr::vector<int> delete_labels(_move_arena.resource());
   if (_blob_histogram.at(source_blob) >= kBlobThreshold) {
     score += _blob_histogram.at(source_blob);
-    delete_labels.insert(source_blob);
+    delete_labels.push_back(source_blob);
   }
   if (_blob_histogram.at(destination_blob) >= kBlobThreshold) {
     score += _blob_histogram.at(destination_blob);
-    delete_labels.insert(destination_blob);
+    if (destination_blob != source_blob) {
+      delete_labels.push_back(destination_blob);
+    }
   }
 
   // if the move was valid switch the tiles for good, and mark them for deletion
@@ -280,22 +737,102 @@ int GameBoard::ExecuteMove(Coordinates source, Coordinates destination) {
   return score;
 }
 
+void GameBoard::EvaluateSwap(SwapResult *result) const {
+  // Same outcome as MoveSpeculator::Evaluate, reading the tiles as if they
+  // were swapped. The region collects every tile looked at, a swap elsewhere
+  // that changes none of them can not change the outcome.
+  result->score = 0;
+  result->deletions.clear();
+  result->region.clear();
+  Coordinates destination_pos = result->destination;
+  if (!OnBoard(destination_pos)) {
+    return;
+  }
+
+  int source = Index(result->source);
+  int destination = Index(destination_pos);
+  auto type_at = [this, source, destination](int index) {
+    if (index == source) {
+      return _tiles[destination].type();
+    } else if (index == destination) {
+      return _tiles[source].type();
+    }
+    return _tiles[index].type();
+  };
+  std::vector<int> &region = result->region;
+  region.push_back(source);
+  region.push_back(destination);
+  result->arena.Reset();
+  std::pmr::memory_resource *scratch = result->arena.resource();
+  auto flood_fill = [this, &type_at, &region,
+                     scratch](int start, std::pmr::vector<int> *blob) {
+    // the border never matches, so no bounds checks are needed
+    PieceType type = type_at(start);
+    std::pmr::unordered_set<int> visited(scratch);
+    visited.insert(start);
+    blob->assign(1, start);
+    for (size_t i = 0; i < blob->size(); i++) {
+      int index = (*blob)[i];
+      for (int offset : _dims.neighbour_offsets) {
+        int neighbour = index + offset;
+        region.push_back(neighbour);
+        if (type_at(neighbour) == type && visited.insert(neighbour).second) {
+          blob->push_back(neighbour);
+        }
+      }
+    }
+  };
+
+  std::pmr::vector<int> source_blob(scratch);
+  std::pmr::vector<int> destination_blob(scratch);
+  flood_fill(source, &source_blob);
+  bool same_blob = std::find(source_blob.begin(), source_blob.end(),
+                             destination) != source_blob.end();
+  if (!same_blob) {
+    flood_fill(destination, &destination_blob);
+  }
+
+  // a blob holding both tiles is counted for both, like a labeled move
+  int source_size = source_blob.size();
+  if (source_size >= kBlobThreshold) {
+    result->score += same_blob ? 2 * source_size : source_size;
+    result->deletions.assign(source_blob.begin(), source_blob.end());
+  }
+  int destination_size = destination_blob.size();
+  if (destination_size >= kBlobThreshold) {
+    result->score += destination_size;
+    result->deletions.insert(result->deletions.end(),
+                             destination_blob.begin(),
+                             destination_blob.end());
+  }
+}
+
 void GameBoard::LabelBlobs() {
+  if (_board_width * _board_height >= _parallel_labeling_threshold) {
+    LabelBlobsParallel();
+    return;
+  }
+
+  DispatchDims([this](const auto &dims) { LabelBlobsKernel(dims); });
+}
+
+template <typename Dims>
+void GameBoard::LabelBlobsKernel(const Dims &dims) {
   // This is a naive labeling algorithm that loops through the 2D board multiple
   // times. As this only happens when the user attempts a move AND the playing
   // field has changed since last attempt, it should not be a performance
-  // bottleneck.
+  // bottleneck for boards below the parallel labeling threshold.
 
   // first pass assign labels, and only check against previously assigned labels
+  _blob_labels.assign(_tiles.size(), kNoLabel);
   int blob_label = 0;
-  for (int x = 0; x < _board_width; x++) {
-    for (int y = 0; y < _board_height; y++) {
-      auto neighbours = GetPastNeighbourBlobs({x, y});
-      auto lowest_neighbour_label = neighbours.cbegin();
-      if (lowest_neighbour_label != neighbours.cend()) {
-        _board[x][y].blob_label = *lowest_neighbour_label;
-      } else {
-        _board[x][y].blob_label = blob_label;
+  for (int x = 0; x < dims.width; x++) {
+    for (int y = 0; y < dims.height; y++) {
+      int index = dims.Index(x, y);
+      int lowest =
+          LowestNeighbourLabel<kPastNeighbourCount>(dims, index, blob_label);
+      _blob_labels[index] = lowest;
+      if (lowest == blob_label) {
         ++blob_label;
       }
     }
@@ -308,78 +845,187 @@ void GameBoard::LabelBlobs() {
     _blob_histogram.clear();
     _blob_histogram.resize(blob_label, 0);
 
-    for (int x = 0; x < _board_width; x++) {
-      for (int y = 0; y < _board_height; y++) {
-        auto neighbours = GetNeighbourBlobs({x, y});
-        auto lowest_neighbour_label = neighbours.cbegin();
-        if (lowest_neighbour_label != neighbours.cend()) {
-          if (*lowest_neighbour_label < _board[x][y].blob_label) {
-            _board[x][y].blob_label = *lowest_neighbour_label;
-            changed = true;
-          }
-        }
-        _blob_histogram[_board[x][y].blob_label]++;
+    for (int x = 0; x < dims.width; x++) {
+      for (int y = 0; y < dims.height; y++) {
+        int index = dims.Index(x, y);
+        int &label = _blob_labels[index];
+        int lowest = LowestNeighbourLabel<kNeighbourCount>(dims, index, label);
+        changed |= lowest != label;
+        label = lowest;
+        _blob_histogram[label]++;
       }
     }
   } while (changed);
 }
 
-std::set<int> GameBoard::GetNeighbourBlobs(Coordinates pos) {
-  return GetNeighbourBlobs(pos, _board[pos.x][pos.y].type);
+void GameBoard::LabelBlobsParallel() {
+  _label_types.resize(_board_width * _board_height);
+  for (int x = 0; x < _board_width; x++) {
+    const BoardTile *column = &_tiles[Index(x, 0)];
+    for (int y = 0; y < _board_height; y++) {
+      _label_types[x * _board_height + y] = column[y].type();
+    }
+  }
+
+  WorkerPool &pool = WorkerPool::Global();
+  int strip_count =
+      std::min(pool.size() + 1, _board_width / kMinLabelingStripWidth);
+  _blob_labeler.Label(_label_types, _board_width, _board_height, pool,
+                      strip_count);
+
+  const auto &labels = _blob_labeler.labels();
+  _blob_labels.assign(_tiles.size(), kNoLabel);
+  for (int x = 0; x < _board_width; x++) {
+    std::copy_n(&labels[x * _board_height], _board_height,
+                &_blob_labels[Index(x, 0)]);
+  }
+  _blob_histogram = _blob_labeler.histogram();
 }
 
-std::set<int> GameBoard::GetNeighbourBlobs(Coordinates pos, PieceType type) {
-  std::set<int> ret;
-  if (pos.x > 0) {
-    if (_board[pos.x - 1][pos.y].type == type) {
-      ret.insert(_board[pos.x - 1][pos.y].blob_label);
+template <int NeighbourCount, typename Dims>
+int GameBoard::LowestNeighbourLabel(const Dims &dims, int index,
+                                    int lowest) const {
+  // the border never matches a piece type, so no bounds checks are needed
+  PieceType type = _tiles[index].type();
+  for (int i = 0; i < NeighbourCount; i++) {
+    int neighbour = index + dims.neighbour_offsets[i];
+    if (_tiles[neighbour].type() == type) {
+      lowest = std::min(lowest, _blob_labels[neighbour]);
     }
   }
-  if (pos.y > 0) {
-    if (_board[pos.x][pos.y - 1].type == type) {
-      ret.insert(_board[pos.x][pos.y - 1].blob_label);
+  return lowest;
+}
+
+GameBoard::BoardTile GameBoard::MakeTile(PieceType type, Animation animation,
+                                         float offset_y) {
+  BoardTile tile = {0, BoardTile::ToFixed(offset_y), 0};
+  tile.set_type(type);
+  tile.set_animation(animation);
+  return tile;
+}
+
+void GameBoard::StartDeletions() {
+  _deletions.clear();
+  ++_deletion_version;
+}
+
+int GameBoard::MarkBlobsForDeletion(
+    const std::pmr::vector<int> &marked_labels) {
+  StartDeletions();
+  for (int x = 0; x < _board_width; x++) {
+    for (int y = 0; y < _board_height; y++) {
+      int index = Index(x, y);
+      if (std::find(marked_labels.begin(), marked_labels.end(),
+                    _blob_labels[index]) != marked_labels.end()) {
+        _tiles[index].set_animation(kDelete);
+        Animate(index);
+        _deletions.push_back({x, y});
+      }
     }
   }
-  if (pos.x < (_board_width - 1)) {
-    if (_board[pos.x + 1][pos.y].type == type) {
-      ret.insert(_board[pos.x + 1][pos.y].blob_label);
-    }
+  return 1;
+}
+
+void GameBoard::MarkTilesForDeletion(const std::vector<int> &indices) {
+  StartDeletions();
+  for (int index : indices) {
+    Coordinates pos(index / _board_height, index % _board_height);
+    _tiles[Index(pos)].set_animation(kDelete);
+    Animate(Index(pos));
+    _deletions.push_back(pos);
   }
-  if (pos.y < (_board_height - 1)) {
-    if (_board[pos.x][pos.y + 1].type == type) {
-      ret.insert(_board[pos.x][pos.y + 1].blob_label);
+}
+
+bool GameBoard::Deleting() const {
+  for (int x = 0; x < _board_width; x++) {
+    const BoardTile *column = &_tiles[Index(x, 0)];
+    bool deleting = std::any_of(
+        column, column + _board_height, [](const BoardTile &tile) {
+          return tile.animation() == kDelete ||
+                 tile.animation() == kDeleteDone;
+        });
+    if (deleting) {
+      return true;
     }
   }
-  return ret;
+  return false;
+}
+
+bool GameBoard::Settled() const {
+  return _drag_starts.empty() && !Deleting();
 }
 
-std::set<int> GameBoard::GetPastNeighbourBlobs(Coordinates pos) {
-  return GetPastNeighbourBlobs(pos, _board[pos.x][pos.y].type);
+void GameBoard::ApplySwap(const MoveJournal::Record &record) {
+  // swapping is its own inverse
+  ++_version;
+  int source_x = record.source / _board_height;
+  int source_y = record.source % _board_height;
+  int destination_x = record.destination / _board_height;
+  int destination_y = record.destination % _board_height;
+  PieceType source_type = tile(source_x, source_y).type();
+  PieceType destination_type = tile(destination_x, destination_y).type();
+  PlaceTile(source_x, source_y, destination_type);
+  PlaceTile(destination_x, destination_y, source_type);
 }
 
-std::set<int> GameBoard::GetPastNeighbourBlobs(Coordinates pos,
-                                               PieceType type) {
-  std::set<int> ret;
-  if (pos.x > 0) {
-    if (_board[pos.x - 1][pos.y].type == type) {
-      ret.insert(_board[pos.x - 1][pos.y].blob_label);
+void GameBoard::ApplyReplenish(const MoveJournal::Record &record) {
+  // compacts the affected columns like DeleteAndReplenish, with the recorded
+  // replacements instead of drawing new ones
+  ++_version;
+  _random.Seek(record.random_after);
+  size_t next = 0;
+  size_t next_type = 0;
+  while (next < record.deleted.size()) {
+    int x = record.deleted[next] / _board_height;
+    BoardTile *column = &_tiles[Index(x, 0)];
+    int column_deletion_count = 0;
+    for (int y = 0; y < _board_height; y++) {
+      if (next < record.deleted.size() &&
+          record.deleted[next] == x * _board_height + y) {
+        ++column_deletion_count;
+        ++next;
+        continue;
+      }
+      PlaceTile(x, y - column_deletion_count, column[y].type());
     }
-  }
-  if (pos.y > 0) {
-    if (_board[pos.x][pos.y - 1].type == type) {
-      ret.insert(_board[pos.x][pos.y - 1].blob_label);
+    for (int y = _board_height - column_deletion_count; y < _board_height;
+         y++) {
+      PlaceTile(x, y, record.replacement_types[next_type++]);
     }
   }
-  return ret;
 }
 
-int GameBoard::MarkBlobsForDeletion(std::set<int> marked_labels) {
-  for (auto &column : _board) {
-    for (auto &tile : column) {
-      if (marked_labels.find(tile.blob_label) != marked_labels.end()) {
-        tile.animation = kDelete;
+void GameBoard::RevertReplenish(const MoveJournal::Record &record) {
+  // Walks each affected column downwards, moving the survivors back up and
+  // restoring the deleted tiles. Survivors only move up, so this works in
+  // place.
+  ++_version;
+  _random.Seek(record.random_before);
+  int last = static_cast<int>(record.deleted.size()) - 1;
+  while (last >= 0) {
+    int x = record.deleted[last] / _board_height;
+    int first = last;
+    while (first > 0 && record.deleted[first - 1] / _board_height == x) {
+      --first;
+    }
+    int column_deletion_count = last - first + 1;
+    const BoardTile *column = &_tiles[Index(x, 0)];
+    int survivor = _board_height - column_deletion_count - 1;
+    int deleted = last;
+    for (int y = _board_height - 1; y >= 0; y--) {
+      int index = x * _board_height + y;
+      if (deleted >= first && record.deleted[deleted] == index) {
+        PlaceTile(x, y, record.deleted_types[deleted--]);
+      } else {
+        PlaceTile(x, y, column[survivor--].type());
       }
     }
+    last = first - 1;
   }
-  return 1;
+}
+
+void GameBoard::PlaceTile(int x, int y, uint8_t type) {
+  _tiles[Index(x, y)] =
+      MakeTile(static_cast<PieceType>(type), kStationary, 0.0f);
+  Animate(Index(x, y));
 }
@@ -1,15 +1,30 @@
 #ifndef SOURCE_GAME_LOGIC_GAME_BOARD_HPP_
 #define SOURCE_GAME_LOGIC_GAME_BOARD_HPP_
 
-#include <random>
-#include <set>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <memory_resource>
+#include <unordered_map>
 #include <vector>
 
+#include "blob_labeler.hpp"
+#include "board_dims.hpp"
+#include "board_generator.hpp"
 #include "coordinates.hpp"
+#include "frame_arena.hpp"
+#include "goal_calibrator.hpp"
+#include "move_journal.hpp"
+#include "move_speculator.hpp"
+#include "random_source.hpp"
+#include "timing_wheel.hpp"
 
 class GameBoard {
  public:
-  enum PieceType { kTux = 0, kHat, kChameleon, kWildebeest };
+  // kNone only fills the border around the board, so neighbour lookups never
+  // need bounds checks
+  enum PieceType { kTux = 0, kHat, kChameleon, kWildebeest, kNone };
   enum Animation {
     kStationary = 0,
     kReturn,
@@ -22,58 +37,284 @@ class GameBoard {
     kEvadeRight,
   };
 
+  // Packed into 6 bytes. Offsets are fixed point in tiles / kOffsetScale,
+  // the low nibble of state holds the piece type and the high nibble the
+  // animation.
+  struct BoardTile {
+    static constexpr float kOffsetScale = 64.0f;
+
+    int16_t fixed_offset_x;
+    int16_t fixed_offset_y;
+    uint8_t state;
+
+    PieceType type() const { return static_cast<PieceType>(state & 0x0F); }
+    Animation animation() const { return static_cast<Animation>(state >> 4); }
+    float offset_x() const { return fixed_offset_x / kOffsetScale; }
+    float offset_y() const { return fixed_offset_y / kOffsetScale; }
+    bool moving() const { return fixed_offset_x != 0 || fixed_offset_y != 0; }
+
+    void set_type(PieceType type) { state = (state & 0xF0) | type; }
+    void set_animation(Animation animation) {
+      state = (state & 0x0F) | animation << 4;
+    }
+    void set_offset_x(float offset) { fixed_offset_x = ToFixed(offset); }
+    void set_offset_y(float offset) { fixed_offset_y = ToFixed(offset); }
+    // saturates, far falling tiles stop at the edge of the range
+    static int16_t ToFixed(float offset) {
+      return std::lrint(
+          std::clamp(offset * kOffsetScale, -32768.0f, 32767.0f));
+    }
+  };
+  static_assert(sizeof(BoardTile) == 6, "BoardTile is uploaded as is");
+
+  // Drags are tracked per pointer, so several people can play on one board.
+  // Touch pointers use their touch ids, the mouse uses kMousePointer.
+  static constexpr int kMousePointer = -1;
+  // tiles are grouped in squares of this size for change_stamp
+  static constexpr int kChangeChunkSize = 32;
   typedef struct {
-    float offset_x;
-    float offset_y;
-    PieceType type;
-    Animation animation;
-    int blob_label;
-  } BoardTile;
-
-  GameBoard(int width, int height);
+    int pointer;
+    CoordinatesF pos;
+  } Release;
+
+  GameBoard(int width, int height,
+            uint64_t seed = RandomSource::kDefaultSeed);
   ~GameBoard();
 
-  void DragStart(CoordinatesF pos);
-  void DragMove(CoordinatesF pos);
-  int DragReleaseAndCheckMove(CoordinatesF pos);
+  // only mouse drags are speculated, every speculation copies the board
+  void DragStart(CoordinatesF pos, int pointer = kMousePointer);
+  void DragMove(CoordinatesF pos, int pointer = kMousePointer);
+  int DragReleaseAndCheckMove(CoordinatesF pos, int pointer = kMousePointer);
+  // Releases several drags at once and returns their scores in order. The
+  // swaps are evaluated in parallel, each only around its own tiles, swaps
+  // looking at the same tiles are evaluated again one after the other. The
+  // scores are valid until the next release.
+  std::pmr::vector<int> DragReleaseAndCheckMoves(
+      const std::vector<Release> &releases);
+  // score of releasing the mouse drag right now, -1 while not known yet
+  int DragPreviewScore() const;
+  // Steps the tiles that are animated or off their place. Returning and
+  // deleting tiles complete on the tick predicted when they started, see
+  // Animate, instead of being checked every tick.
   void PhysicsTick();
+  // Undoes the latest or redoes the next journaled move, only while neither a
+  // drag nor a deletion is in progress. Moves that overlap, see MoveJournal,
+  // are undone and redone together. Restored tiles are stationary. Returns
+  // false when there is no such move, score is the score of the moves.
+  bool UndoMove(int *score);
+  bool RedoMove(int *score);
+  const MoveJournal &journal() const { return _journal; }
 
   void Create(int width, int height);
+  // creates a board from column major piece types, see GenerateTypes
+  void Create(int width, int height, const std::vector<uint8_t> &types);
+  // creates a board from a packed grid of a LevelPack, straight from the
+  // mapping without copying it first
+  void CreatePacked(int width, int height, const uint8_t *grid);
   void Clear();
+  // piece types without blobs that allow at least a few moves, only depends
+  // on its arguments so it can run on a worker
+  static std::vector<uint8_t> GenerateTypes(int width, int height,
+                                            uint64_t seed);
+  // goal for a board of the given piece types, see GoalCalibrator, runs in
+  // parallel on the worker pool
+  static int CalibrateGoal(const std::vector<uint8_t> &types, int width,
+                           int height, uint64_t seed,
+                           const GoalCalibrator::Options &options);
+  // seed for the next generated board, taken from the board's random source
+  uint64_t DrawSeed();
+  // restarts the random sequence, boards created after this are reproducible
+  void Seed(uint64_t seed) { _random.Seed(seed); }
+  uint64_t seed() const { return _random.seed(); }
+  // boards with at least this many tiles are labeled on the worker pool
+  void SetParallelLabelingThreshold(int tile_count) {
+    _parallel_labeling_threshold = tile_count;
+  }
 
   int width() const { return _board_width; }
   int height() const { return _board_height; }
-  const std::vector<std::vector<BoardTile>> &board() const { return _board; };
+  // changes whenever any piece type on the board changes
+  uint64_t version() const { return _version; }
+  // tiles marked for deletion by the latest deleting move, deletion_version
+  // changes with every such move
+  const std::vector<Coordinates> &deletions() const { return _deletions; }
+  uint64_t deletion_version() const { return _deletion_version; }
+  const BoardTile &tile(int x, int y) const { return _tiles[Index(x, y)]; }
+  // the height() tiles of column x, bottom to top
+  const BoardTile *column(int x) const { return &_tiles[Index(x, 0)]; }
+  // Changes whenever any tile of the chunk at chunk_x * kChangeChunkSize,
+  // chunk_y * kChangeChunkSize changes, also when the board is created anew.
+  // Views compare it with the stamp they last drew, so they only look at the
+  // chunks that changed.
+  uint64_t change_stamp(int chunk_x, int chunk_y) const {
+    return _change_stamps[chunk_x * ChangeChunkRows() + chunk_y];
+  }
+  // calls function with the position of every tile that is animated or off
+  // its place, once each, tiles that just settled may be included
+  template <typename Function>
+  void ForEachAnimated(Function &&function) const {
+    for (int index : _animated) {
+      function(Position(index));
+    }
+    for (int index : _newly_animated) {
+      function(Position(index));
+    }
+  }
+  // moves a tile away from its place as if it were animating, for tools that
+  // need board states without playing up to them
+  void SetTileOffset(int x, int y, float offset_x, float offset_y);
 
  private:
   static constexpr float kEvadeThreshold = 0.9f;
   static constexpr float kReturnSpeed = 0.8f;
   static constexpr float kStationaryThreshold = 0.1f;
   static constexpr float kFallSpeed = 0.2f;
+  static constexpr float kDeleteSpeed = 0.2f;
   static constexpr float kDeleteThreshold = 2.0f;
   static constexpr int kBlobThreshold = 3;
+  static constexpr int kPieceTypeCount = kWildebeest + 1;
+  static constexpr int kMinGeneratedMoves = 3;
+  // chance per tick that a falling tile starts over from the top
+  static constexpr double kFallRestartChance = 1.0 / 1001;
+  static constexpr int kDefaultParallelLabelingThreshold = 256 * 256;
+  static constexpr int kMinLabelingStripWidth = 32;
+  // see RuntimeBoardDims, the first two neighbours were visited before in
+  // column major order
+  static constexpr int kNeighbourCount = 4;
+  static constexpr int kPastNeighbourCount = 2;
+  static constexpr int kNoLabel = -1;
+
+  int Index(int x, int y) const { return _dims.Index(x, y); }
+  int Index(Coordinates pos) const { return Index(pos.x, pos.y); }
+  Coordinates Position(int index) const {
+    return Coordinates(index / _dims.stride - 1, index % _dims.stride - 1);
+  }
+  int ChangeChunkRows() const {
+    return (_board_height + kChangeChunkSize - 1) / kChangeChunkSize;
+  }
+  bool OnBoard(Coordinates pos) const {
+    return pos.x >= 0 && pos.x < _board_width && pos.y >= 0 &&
+           pos.y < _board_height;
+  }
 
+  // empties the board for tiles of a new size, keeps the memory of larger ones
+  void Reset(int width, int height);
   BoardTile &TileAt(CoordinatesF pos);
   CoordinatesF ClampToBoard(CoordinatesF pos);
-  void EvadeTile();
+  // outcome of a released swap, tile indices are Index values
+  typedef struct {
+    int release;
+    Coordinates source;
+    Coordinates destination;
+    int score;
+    std::vector<int> deletions;
+    // tiles the evaluation looked at
+    std::vector<int> region;
+    // scratch of the worker evaluating the swap
+    FrameArena arena;
+  } SwapResult;
+
+  void EvadeTile(CoordinatesF start_pos);
   void EvadeCancel(Coordinates pos);
+  Coordinates DragDestination(Coordinates source, float delta_x,
+                              float delta_y) const;
+  void StartSpeculation(Coordinates source);
+  // only reads the board, so several can run at once
+  void EvaluateSwap(SwapResult *result) const;
   void SwapTile(Coordinates source, Coordinates destination);
+  // overlaps when deletions were running before the swap was made
+  void JournalSwap(Coordinates source, Coordinates destination, int score,
+                   bool overlaps);
   void DeleteAndReplenish();
+  bool Deleting() const;
+  // no tile is being deleted and nothing is dragged
+  bool Settled() const;
+  void ApplySwap(const MoveJournal::Record &record);
+  void ApplyReplenish(const MoveJournal::Record &record);
+  void RevertReplenish(const MoveJournal::Record &record);
+  void PlaceTile(int x, int y, uint8_t type);
+  // both tiles must be on the board, swaps with tiles off it score 0
   int ExecuteMove(Coordinates source, Coordinates destination);
   void LabelBlobs();
-  std::set<int> GetNeighbourBlobs(Coordinates pos);
-  std::set<int> GetNeighbourBlobs(Coordinates pos, PieceType type);
-  std::set<int> GetPastNeighbourBlobs(Coordinates pos);
-  std::set<int> GetPastNeighbourBlobs(Coordinates pos, PieceType type);
-  int MarkBlobsForDeletion(std::set<int> marked_labels);
+  void LabelBlobsParallel();
+  // calls function with FixedBoardDims for the sizes of the first levels, see
+  // GameLogic, and with the runtime dimensions for all other sizes
+  template <typename Function>
+  void DispatchDims(Function &&function);
+  // steps the animated tiles in column major order, so falling tiles draw
+  // from the random source in the same order every time
+  void StepAnimations();
+  // applies the completions due this tick and replenishes deleted tiles
+  void CompleteAnimations();
+  // Call after changing the animation or offsets of a tile at index from
+  // outside StepAnimations. Schedules when the tile completes, replacing its
+  // earlier completion, and steps it from the next tick on.
+  void Animate(int index);
+  // bumps the change stamp of the chunk of the tile at index
+  void MarkChanged(int index);
+  // ticks until a returning or deleting tile completes, 0 for other tiles
+  static int TicksToComplete(BoardTile tile);
+  template <typename Dims>
+  void LabelBlobsKernel(const Dims &dims);
+  template <int NeighbourCount, typename Dims>
+  int LowestNeighbourLabel(const Dims &dims, int index, int lowest) const;
+  static BoardTile MakeTile(PieceType type, Animation animation,
+                            float offset_y);
+  void StartDeletions();
+  int MarkBlobsForDeletion(const std::pmr::vector<int> &marked_labels);
+  void MarkTilesForDeletion(const std::vector<int> &indices);
 
-  std::vector<std::vector<BoardTile>> _board;
+  // column major with a one tile border of kNone, see Index
+  std::vector<BoardTile> _tiles;
+  RuntimeBoardDims _dims;
+  // blob label per tile, indexed like _tiles, only valid after labeling
+  std::vector<int> _blob_labels;
   std::vector<int> _blob_histogram;
-  std::default_random_engine _random_generator;
+  BlobLabeler _blob_labeler;
+  std::vector<uint8_t> _label_types;
+  int _parallel_labeling_threshold;
+  RandomSource _random;
+  std::vector<uint8_t> _type_buffer;
+  // ticks until each falling tile restarts, indexed like _tiles
+  std::vector<int> _fall_restart_countdown;
   int _board_width;
   int _board_height;
-  CoordinatesF _drag_start_pos;
+  // start position of every active drag by pointer
+  std::unordered_map<int, CoordinatesF> _drag_starts;
+  uint64_t _version;
+  std::vector<Coordinates> _deletions;
+  uint64_t _deletion_version;
+  MoveSpeculator _move_speculator;
+  // scratch of the release being resolved
+  FrameArena _move_arena;
+  // only grows, so the arenas of the results stay warm
+  std::vector<SwapResult> _swap_results;
+  // tiles looked at by the swaps applied so far in a batch of releases hold
+  // the batch's stamp
+  std::vector<uint32_t> _region_stamps;
+  uint32_t _region_stamp;
+  MoveJournal _journal;
+  // reused for every record, so journaling does not allocate once warm
+  MoveJournal::Record _journal_record;
   bool _board_tiles_changed;
+  uint64_t _tick;
+  // completions of returning and deleting tiles, keyed by Index
+  TimingWheel _completions;
+  std::vector<TimingWheel::Event> _fired_completions;
+  // bumped with every Animate, indexed like _tiles, completions scheduled with
+  // an older stamp are outdated
+  std::vector<uint32_t> _completion_stamps;
+  // indices of the tiles that are animated or off their place, ascending,
+  // tiles animated since the last tick wait in _newly_animated
+  std::vector<int> _animated;
+  std::vector<int> _newly_animated;
+  std::vector<int> _animated_merge;
+  std::vector<uint8_t> _animated_flags;
+  // deletions completed this tick, ascending
+  std::vector<int> _completed_deletions;
+  // per change chunk, column major, see change_stamp
+  std::vector<uint64_t> _change_stamps;
+  uint64_t _change_stamp;
 };
 
 #endif  // SOURCE_GAME_LOGIC_GAME_BOARD_HPP_
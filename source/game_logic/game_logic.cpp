@@ -3,11 +3,27 @@
 #include <algorithm>
 #include <array>
 #include <iostream>
+#include <utility>
 
-GameLogic::GameLogic() : _board(9, 9), _state(kPaused), _goal(50), _score(0) {}
+#include "worker_pool.hpp"
+
+GameLogic::GameLogic(uint64_t seed)
+    : _board(9, 9, seed),
+      _state(kPaused),
+      _goal(kFirstGoal),
+      _score(0),
+      _level(0) {}
 
 GameLogic::~GameLogic() {}
 
+void GameLogic::Seed(uint64_t seed) {
+  _board.Seed(seed);
+  _board.Create(_board.width(), _board.height());
+  if (_next_board.valid()) {
+    PrefetchNextBoard();
+  }
+}
+
 void GameLogic::MouseClick(float x, float y) {
   if (_state == kPlaying) {
     _board.DragStart({x, y});
@@ -21,13 +37,83 @@ void GameLogic::MouseMove(float x, float y) {
 }
 
 void GameLogic::MouseRelease(float x, float y) {
+  if (_state == kPlaying) {
+    AddScore(_board.DragReleaseAndCheckMove({x, y}));
+  } else {
+    Advance();
+  }
+}
+
+void GameLogic::PointerPress(int pointer, float x, float y) {
+  if (_state == kPlaying) {
+    _board.DragStart({x, y}, pointer);
+  }
+}
+
+void GameLogic::PointerMove(int pointer, float x, float y) {
+  if (_state == kPlaying) {
+    _board.DragMove({x, y}, pointer);
+  }
+}
+
+void GameLogic::PointerRelease(
+    const std::vector<GameBoard::Release> &releases) {
+  if (releases.empty()) {
+    return;
+  }
+  if (_state == kPlaying) {
+    int score = 0;
+    for (int move_score : _board.DragReleaseAndCheckMoves(releases)) {
+      score += move_score;
+    }
+    AddScore(score);
+  } else {
+    Advance();
+  }
+}
+
+void GameLogic::PhysicsTick() {
+  _board.PhysicsTick();
+  if (_publisher) {
+    _publisher->Publish(_board, _score, _goal, _state);
+  }
+}
+
+bool GameLogic::PublishState(const std::string &name) {
+  auto publisher = std::make_unique<StatePublisher>();
+  if (!publisher->Open(name)) {
+    return false;
+  }
+  _publisher = std::move(publisher);
+  return true;
+}
+
+bool GameLogic::UseLevelPack(std::shared_ptr<const LevelPack> pack) {
+  _level_pack = std::move(pack);
+  _level = 0;
+  if (!CreatePackLevel()) {
+    _level_pack.reset();
+    return false;
+  }
+  _score = 0;
+  _state = kPaused;
+  return true;
+}
+
+void GameLogic::AddScore(int score) {
+  _score += score;
+  if (_score >= _goal) {
+    _board.Clear();
+    _state = kLevelComplete;
+    if (!HasPackLevel(_level + 1)) {
+      PrefetchNextBoard();
+    }
+  }
+}
+
+void GameLogic::Advance() {
   switch (_state) {
     case kPlaying: {
-      _score += _board.DragReleaseAndCheckMove({x, y});
-      if (_score >= _goal) {
-        _board.Clear();
-        _state = kLevelComplete;
-      }
       break;
     }
     case kPaused: {
@@ -35,11 +121,76 @@ void GameLogic::MouseRelease(float x, float y) {
       break;
     }
     case kLevelComplete: {
-      _goal *= 1.5f;
-      _board.Create(_board.width() + 3, _board.height() + 3);
+      ++_level;
+      if (!CreatePackLevel()) {
+        if (!_next_board.valid()) {
+          PrefetchNextBoard();
+        }
+        GeneratedLevel level = _next_board.get();
+        _board.Create(_board.width() + kLevelGrowth,
+                      _board.height() + kLevelGrowth, level.types);
+        _goal = level.goal;
+      }
       _score = 0;
       _state = kPlaying;
       break;
     }
   }
 }
+
+bool GameLogic::Undo() {
+  int score = 0;
+  if (_state != kPlaying || !_board.UndoMove(&score)) {
+    return false;
+  }
+  _score -= score;
+  return true;
+}
+
+bool GameLogic::Redo() {
+  int score = 0;
+  if (_state != kPlaying || !_board.RedoMove(&score)) {
+    return false;
+  }
+  _score += score;
+  return true;
+}
+
+bool GameLogic::RewindTo(int move) {
+  while (this->move() > move && Undo()) {
+  }
+  while (this->move() < move && Redo()) {
+  }
+  return this->move() == move;
+}
+
+void GameLogic::PrefetchNextBoard() {
+  int width = _board.width() + kLevelGrowth;
+  int height = _board.height() + kLevelGrowth;
+  uint64_t seed = _board.DrawSeed();
+  GoalCalibrator::Options options = GoalOptions(_level + 1);
+  _next_board = WorkerPool::Global().Run([width, height, seed, options]() {
+    GeneratedLevel level;
+    level.types = GameBoard::GenerateTypes(width, height, seed);
+    level.goal =
+        GameBoard::CalibrateGoal(level.types, width, height, seed, options);
+    return level;
+  });
+}
+
+GoalCalibrator::Options GameLogic::GoalOptions(int level) {
+  return {kGoalPlayouts, kFirstLevelMoves + kMovesPerLevel * level,
+          kGoalCompletionRate};
+}
+
+bool GameLogic::CreatePackLevel() {
+  LevelPack::Level level;
+  if (!HasPackLevel(_level) || !_level_pack->GetLevel(_level, &level)) {
+    return false;
+  }
+  // seeded, so every player of the pack draws the same replacements
+  _board.Seed(level.seed);
+  _board.CreatePacked(level.width, level.height, level.grid);
+  _goal = level.goal;
+  return true;
+}
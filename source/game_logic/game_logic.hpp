@@ -1,24 +1,58 @@
 #ifndef SOURCE_GAME_LOGIC_GAME_LOGIC_HPP_
 #define SOURCE_GAME_LOGIC_GAME_LOGIC_HPP_
 
+#include <future>
+#include <memory>
 #include <random>
 #include <set>
+#include <string>
 #include <unordered_set>
+#include <vector>
 
 #include "coordinates.hpp"
 #include "game_board.hpp"
+#include "level_pack.hpp"
+#include "state_publisher.hpp"
 
 class GameLogic {
  public:
   enum GameState { kPlaying = 0, kPaused, kLevelComplete };
 
-  GameLogic();
+  explicit GameLogic(uint64_t seed = RandomSource::kDefaultSeed);
   ~GameLogic();
 
+  // regenerates the current level from the given seed
+  void Seed(uint64_t seed);
+  uint64_t seed() const { return _board.seed(); }
+
   void MouseClick(float x, float y);
   void MouseMove(float x, float y);
   void MouseRelease(float x, float y);
-  void PhysicsTick() { _board.PhysicsTick(); }
+  // touch points, several can drag at once, see GameBoard::DragStart
+  void PointerPress(int pointer, float x, float y);
+  void PointerMove(int pointer, float x, float y);
+  // releases that happened together, their swaps are resolved as one batch
+  void PointerRelease(const std::vector<GameBoard::Release> &releases);
+  void PhysicsTick();
+  // publishes the state after every tick into the named shared memory, see
+  // StatePublisher, returns false when the segment could not be created
+  bool PublishState(const std::string &name);
+  // Starts over with the first level of pack and plays its levels in order,
+  // then continues with generated levels growing from the last one. Returns
+  // false when the pack has no usable first level.
+  bool UseLevelPack(std::shared_ptr<const LevelPack> pack);
+  // calibration of the goal of generated level, counted from 0, see
+  // GameBoard::CalibrateGoal
+  static GoalCalibrator::Options GoalOptions(int level);
+  // steps through the moves of the current level, see GameBoard::UndoMove
+  bool Undo();
+  bool Redo();
+  // undoes or redoes moves until move() is the given one, stops early when a
+  // move is not available and passes it when it is among overlapping moves,
+  // returns whether it got there
+  bool RewindTo(int move);
+  // moves made on this level, minus the undone ones
+  int move() const { return _board.journal().move(); }
 
   int width() const { return _board.width(); }
   int height() const { return _board.height(); }
@@ -26,13 +60,48 @@ class GameLogic {
   int goal() const { return _goal; }
   int score() const { return _score; }
   GameState state() const { return _state; }
+  // score the current drag would make, -1 while unknown or not dragging
+  int drag_preview_score() const {
+    return _state == kPlaying ? _board.DragPreviewScore() : -1;
+  }
 
  private:
+  static constexpr int kLevelGrowth = 3;
+  static constexpr int kFirstGoal = 50;
+  // Goals of generated levels are reached by kGoalCompletionRate of simple
+  // players within a number of moves that grows with every level.
+  static constexpr int kFirstLevelMoves = 12;
+  static constexpr int kMovesPerLevel = 4;
+  static constexpr float kGoalCompletionRate = 0.8f;
+  static constexpr int kGoalPlayouts = 1024;
+
+  typedef struct {
+    std::vector<uint8_t> types;
+    int goal;
+  } GeneratedLevel;
+
+  void AddScore(int score);
+  // leaves the pause or starts the next level
+  void Advance();
+  // generates the next level's board and calibrates its goal on the worker
+  // pool while the current level clears
+  void PrefetchNextBoard();
+  // creates level _level from the level pack, false when it has none
+  bool CreatePackLevel();
+  bool HasPackLevel(int level) const {
+    return _level_pack && level < _level_pack->level_count();
+  }
+
   GameBoard _board;
   GameState _state;
   CoordinatesF _click_pos;
   int _goal;
   int _score;
+  std::future<GeneratedLevel> _next_board;
+  std::unique_ptr<StatePublisher> _publisher;
+  std::shared_ptr<const LevelPack> _level_pack;
+  // levels completed since the start or the last level pack
+  int _level;
 };
 
 #endif  // SOURCE_GAME_LOGIC_GAME_LOGIC_HPP_
@@ -0,0 +1,220 @@
+#include "goal_calibrator.hpp"
+
+#include <algorithm>
+#include <array>
+#include <utility>
+
+#include "random_source.hpp"
+#include "worker_pool.hpp"
+
+namespace {
+
+// Plays one board after the other with the calibration policy. Moves are
+// resolved like GameBoard resolves them, without animating.
+class Playout {
+ public:
+  Playout(int width, int height, int type_count, int blob_threshold)
+      : _width(width),
+        _height(height),
+        _type_count(type_count),
+        _blob_threshold(blob_threshold),
+        _visited(width * height, 0),
+        _stamp(0),
+        _source(0),
+        _destination(0),
+        _deleted_columns(width, 0) {}
+
+  // plays until move_budget moves are made or no move is left, returns the
+  // score
+  int Play(const std::vector<uint8_t> &types, int move_budget,
+           RandomSource &random) {
+    _types = types;
+    int score = 0;
+    for (int move = 0; move < move_budget; move++) {
+      int move_score = FindMove(random);
+      if (move_score == 0) {
+        break;
+      }
+      score += move_score;
+      DeleteAndReplenish(random);
+    }
+    return score;
+  }
+
+ private:
+  // random swaps tried per tile before looking at all of them
+  static constexpr int kSamplesPerTile = 2;
+  static constexpr uint8_t kDeleted = 0xFF;
+
+  // Picks a random move among those that score and evaluates it last, so its
+  // blobs are left in _source_blob and _destination_blob. Returns 0 when
+  // there is none.
+  int FindMove(RandomSource &random) {
+    // sampling finds one quickly while moves are plenty, and picks every
+    // scoring swap with the same chance
+    int tile_count = _width * _height;
+    for (int sample = 0; sample < kSamplesPerTile * tile_count; sample++) {
+      int source = random.Uniform(tile_count);
+      int destination = Neighbour(source, random.Uniform(2));
+      if (destination >= 0) {
+        int score = Evaluate(source, destination);
+        if (score > 0) {
+          return score;
+        }
+      }
+    }
+
+    // few or no moves are left, so look at all of them
+    _moves.clear();
+    for (int source = 0; source < tile_count; source++) {
+      for (int direction = 0; direction < 2; direction++) {
+        int destination = Neighbour(source, direction);
+        if (destination >= 0 && Evaluate(source, destination) > 0) {
+          _moves.push_back(source * 2 + direction);
+        }
+      }
+    }
+    if (_moves.empty()) {
+      return 0;
+    }
+    int move = _moves[random.Uniform(_moves.size())];
+    return Evaluate(move / 2, Neighbour(move / 2, move % 2));
+  }
+
+  // right or upper neighbour, -1 at the edge
+  int Neighbour(int index, int direction) const {
+    if (direction == 0) {
+      return index / _height < _width - 1 ? index + _height : -1;
+    }
+    return index % _height < _height - 1 ? index + 1 : -1;
+  }
+
+  // score of swapping the tiles, like GameBoard::EvaluateSwap
+  int Evaluate(int source, int destination) {
+    _source = source;
+    _destination = destination;
+    std::swap(_types[source], _types[destination]);
+    if (++_stamp == 0) {
+      std::fill(_visited.begin(), _visited.end(), 0);
+      _stamp = 1;
+    }
+    FloodFill(source, &_source_blob);
+    bool same_blob = _visited[destination] == _stamp;
+    _destination_blob.clear();
+    if (!same_blob) {
+      FloodFill(destination, &_destination_blob);
+    }
+    std::swap(_types[source], _types[destination]);
+
+    // a blob holding both tiles is counted for both, like a labeled move
+    int score = 0;
+    int source_size = _source_blob.size();
+    if (source_size >= _blob_threshold) {
+      score += same_blob ? 2 * source_size : source_size;
+    } else {
+      _source_blob.clear();
+    }
+    int destination_size = _destination_blob.size();
+    if (destination_size >= _blob_threshold) {
+      score += destination_size;
+    } else {
+      _destination_blob.clear();
+    }
+    return score;
+  }
+
+  void FloodFill(int start, std::vector<int> *blob) {
+    uint8_t type = _types[start];
+    _visited[start] = _stamp;
+    blob->assign(1, start);
+    for (size_t i = 0; i < blob->size(); i++) {
+      int index = (*blob)[i];
+      int x = index / _height;
+      int y = index % _height;
+      std::array<int, 4> neighbours = {
+          {x > 0 ? index - _height : -1, x < _width - 1 ? index + _height : -1,
+           y > 0 ? index - 1 : -1, y < _height - 1 ? index + 1 : -1}};
+      for (int neighbour : neighbours) {
+        if (neighbour >= 0 && _visited[neighbour] != _stamp &&
+            _types[neighbour] == type) {
+          _visited[neighbour] = _stamp;
+          blob->push_back(neighbour);
+        }
+      }
+    }
+  }
+
+  // applies the move evaluated last, its blobs are deleted and their
+  // columns compacted and refilled from the top
+  void DeleteAndReplenish(RandomSource &random) {
+    std::swap(_types[_source], _types[_destination]);
+    for (const std::vector<int> *blob : {&_source_blob, &_destination_blob}) {
+      for (int index : *blob) {
+        _types[index] = kDeleted;
+        _deleted_columns[index / _height] = 1;
+      }
+    }
+    for (int x = 0; x < _width; x++) {
+      if (!_deleted_columns[x]) {
+        continue;
+      }
+      _deleted_columns[x] = 0;
+      uint8_t *column = &_types[x * _height];
+      int kept = 0;
+      for (int y = 0; y < _height; y++) {
+        if (column[y] != kDeleted) {
+          column[kept++] = column[y];
+        }
+      }
+      random.FillTypes(column + kept, _height - kept, _type_count);
+    }
+  }
+
+  int _width;
+  int _height;
+  int _type_count;
+  int _blob_threshold;
+  std::vector<uint8_t> _types;
+  // tiles filled by the current evaluation hold its stamp
+  std::vector<uint32_t> _visited;
+  uint32_t _stamp;
+  // the move evaluated last and its blobs
+  int _source;
+  int _destination;
+  std::vector<int> _source_blob;
+  std::vector<int> _destination_blob;
+  // scoring swaps as source * 2 + direction
+  std::vector<int> _moves;
+  std::vector<uint8_t> _deleted_columns;
+};
+
+}  // namespace
+
+GoalCalibrator::GoalCalibrator(int type_count, int blob_threshold)
+    : _type_count(type_count), _blob_threshold(blob_threshold) {}
+
+int GoalCalibrator::Calibrate(const std::vector<uint8_t> &types, int width,
+                              int height, uint64_t seed,
+                              const Options &options,
+                              WorkerPool &pool) const {
+  int playouts = std::max(1, options.playouts);
+  std::vector<int> scores(playouts);
+  int task_count = (playouts + kPlayoutsPerTask - 1) / kPlayoutsPerTask;
+  pool.ParallelFor(task_count, [&](int task) {
+    Playout playout(width, height, _type_count, _blob_threshold);
+    int end = std::min(playouts, (task + 1) * kPlayoutsPerTask);
+    for (int i = task * kPlayoutsPerTask; i < end; i++) {
+      // every playout draws from its own stretch of the seed's sequence
+      RandomSource random(seed);
+      random.Seek(static_cast<uint64_t>(i) << 32);
+      scores[i] = playout.Play(types, options.move_budget, random);
+    }
+  });
+
+  // completion_rate of the playouts score at least as much as the playout at
+  // the failing share
+  int failing = static_cast<int>((1.0f - options.completion_rate) * playouts);
+  failing = std::clamp(failing, 0, playouts - 1);
+  std::nth_element(scores.begin(), scores.begin() + failing, scores.end());
+  return std::max(1, scores[failing]);
+}
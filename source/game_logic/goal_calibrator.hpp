@@ -0,0 +1,42 @@
+#ifndef SOURCE_GAME_LOGIC_GOAL_CALIBRATOR_HPP_
+#define SOURCE_GAME_LOGIC_GOAL_CALIBRATOR_HPP_
+
+#include <cstdint>
+#include <vector>
+
+class WorkerPool;
+
+// Derives the goal of a level from how its board plays. The board is played
+// many times on the worker pool with a simple policy, every move is a random
+// one of the moves that score, like a player who finds a valid move rather
+// than the best one. The goal is the score that completion_rate of the
+// playouts reach within the move budget. Playouts end early when the board
+// runs out of moves, so boards that dead end get lower goals. Every playout
+// only depends on the seed and its number, so the goal is the same on any
+// number of cores.
+class GoalCalibrator {
+ public:
+  typedef struct {
+    int playouts;
+    // moves a player is expected to make on the level
+    int move_budget;
+    // share of the playouts that reach the goal
+    float completion_rate;
+  } Options;
+
+  GoalCalibrator(int type_count, int blob_threshold);
+
+  // types are column major, like BoardGenerator's
+  int Calibrate(const std::vector<uint8_t> &types, int width, int height,
+                uint64_t seed, const Options &options,
+                WorkerPool &pool) const;
+
+ private:
+  // playouts per parallel task, they share the task's scratch
+  static constexpr int kPlayoutsPerTask = 16;
+
+  int _type_count;
+  int _blob_threshold;
+};
+
+#endif  // SOURCE_GAME_LOGIC_GOAL_CALIBRATOR_HPP_
@@ -0,0 +1,152 @@
+#include "level_pack.hpp"
+
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define TUX_MATCH_MEMORY_MAP
+#endif
+
+static_assert(sizeof(LevelPack::Header) == 32 && sizeof(LevelPack::Entry) == 32,
+              "the pack layout must not depend on the compiler");
+
+LevelPack::LevelPack()
+    : _fd(-1), _memory(nullptr), _size(0), _level_count(0) {}
+
+#ifdef TUX_MATCH_MEMORY_MAP
+
+LevelPack::~LevelPack() {
+  if (_memory != nullptr) {
+    munmap(const_cast<void *>(_memory), _size);
+  }
+  if (_fd >= 0) {
+    close(_fd);
+  }
+}
+
+bool LevelPack::Open(const std::string &path) {
+  _fd = open(path.c_str(), O_RDONLY);
+  struct stat status;
+  if (_fd < 0 || fstat(_fd, &status) != 0) {
+    std::cerr << "could not open level pack " << path << ": "
+              << std::strerror(errno) << std::endl;
+    return false;
+  }
+  size_t size = status.st_size;
+  if (size < sizeof(Header)) {
+    std::cerr << path << " is no level pack" << std::endl;
+    return false;
+  }
+  // pages are only read in when their levels are looked up
+  void *memory = mmap(nullptr, size, PROT_READ, MAP_SHARED, _fd, 0);
+  if (memory == MAP_FAILED) {
+    std::cerr << "could not map level pack " << path << ": "
+              << std::strerror(errno) << std::endl;
+    return false;
+  }
+  _memory = memory;
+  _size = size;
+
+  const Header *header = static_cast<const Header *>(_memory);
+  if (header->magic != kMagic || header->version != kVersion) {
+    std::cerr << path << " is no level pack of version " << kVersion
+              << std::endl;
+    return false;
+  }
+  bool index_fits = header->index_offset % alignof(Entry) == 0 &&
+                    header->index_offset <= _size &&
+                    header->level_count <= INT_MAX &&
+                    header->level_count <=
+                        (_size - header->index_offset) / sizeof(Entry);
+  if (!index_fits) {
+    std::cerr << path << " is damaged, its index does not fit" << std::endl;
+    return false;
+  }
+  _level_count = static_cast<int>(header->level_count);
+  return true;
+}
+
+#else
+
+LevelPack::~LevelPack() {}
+
+bool LevelPack::Open(const std::string &path) {
+  std::cerr << "level packs are not available for " << path << std::endl;
+  return false;
+}
+
+#endif  // TUX_MATCH_MEMORY_MAP
+
+bool LevelPack::GetLevel(int index, Level *level) const {
+  if (index < 0 || index >= _level_count) {
+    return false;
+  }
+  const char *bytes = static_cast<const char *>(_memory);
+  const Header *header = reinterpret_cast<const Header *>(bytes);
+  const Entry &entry = reinterpret_cast<const Entry *>(
+      bytes + header->index_offset)[index];
+  bool valid = entry.width > 0 && entry.width <= kMaxSize &&
+               entry.height > 0 && entry.height <= kMaxSize &&
+               entry.goal > 0 && entry.grid_offset <= _size &&
+               GridSize(entry.width, entry.height) <=
+                   _size - entry.grid_offset;
+  if (!valid) {
+    return false;
+  }
+  level->width = entry.width;
+  level->height = entry.height;
+  level->goal = entry.goal;
+  level->seed = entry.seed;
+  level->grid = reinterpret_cast<const uint8_t *>(bytes + entry.grid_offset);
+  return true;
+}
+
+void LevelPackWriter::AddLevel(int width, int height, int goal,
+                               uint64_t seed,
+                               const std::vector<uint8_t> &types) {
+  LevelPack::Entry entry = {};
+  entry.width = width;
+  entry.height = height;
+  entry.goal = goal;
+  entry.seed = seed;
+  entry.grid_offset = _grids.size();
+  _entries.push_back(entry);
+
+  size_t begin = _grids.size();
+  _grids.resize(begin + LevelPack::GridSize(width, height), 0);
+  for (int i = 0; i < width * height; i++) {
+    _grids[begin + i / 4] |= (types[i] & 0x03)
+                             << (i % 4 * LevelPack::kBitsPerTile);
+  }
+}
+
+bool LevelPackWriter::Write(const std::string &path) const {
+  LevelPack::Header header = {};
+  header.magic = LevelPack::kMagic;
+  header.version = LevelPack::kVersion;
+  header.level_count = _entries.size();
+  header.index_offset = sizeof(header);
+  uint64_t grids_offset =
+      header.index_offset + _entries.size() * sizeof(LevelPack::Entry);
+
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  for (LevelPack::Entry entry : _entries) {
+    entry.grid_offset += grids_offset;
+    file.write(reinterpret_cast<const char *>(&entry), sizeof(entry));
+  }
+  file.write(reinterpret_cast<const char *>(_grids.data()), _grids.size());
+  file.close();
+  if (!file) {
+    std::cerr << "could not write level pack " << path << std::endl;
+    return false;
+  }
+  return true;
+}
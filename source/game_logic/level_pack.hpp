@@ -0,0 +1,91 @@
+#ifndef SOURCE_GAME_LOGIC_LEVEL_PACK_HPP_
+#define SOURCE_GAME_LOGIC_LEVEL_PACK_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Curated or seeded levels in one binary file, mapped read only. The file
+// starts with a Header, followed by level_count Entry records and the piece
+// grids they point to. Grids hold 2 bits per tile, column major, four tiles
+// per byte starting at the low bits. Opening only checks the header, levels
+// are checked when they are looked up, so packs of any size open in constant
+// time. Numbers are stored in host byte order, little endian on every
+// platform built for.
+class LevelPack {
+ public:
+  static constexpr uint32_t kMagic = 0x504C4D54;  // "TMLP"
+  static constexpr uint32_t kVersion = 1;
+  static constexpr int kBitsPerTile = 2;
+  static constexpr int kMaxSize = 4096;
+
+  typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t level_count;
+    // from the start of the file, like all offsets
+    uint64_t index_offset;
+    uint64_t reserved;
+  } Header;
+
+  typedef struct {
+    int32_t width;
+    int32_t height;
+    int32_t goal;
+    uint32_t reserved;
+    // seeds the board's random source, so replacements are the same for all
+    uint64_t seed;
+    uint64_t grid_offset;
+  } Entry;
+
+  typedef struct {
+    int width;
+    int height;
+    int goal;
+    uint64_t seed;
+    // packed piece types inside the mapping, see GameBoard::CreatePacked
+    const uint8_t *grid;
+  } Level;
+
+  LevelPack();
+  ~LevelPack();
+  LevelPack(const LevelPack &) = delete;
+  LevelPack &operator=(const LevelPack &) = delete;
+
+  bool Open(const std::string &path);
+  int level_count() const { return _level_count; }
+  // false when there is no such level or its entry is damaged
+  bool GetLevel(int index, Level *level) const;
+
+  static size_t GridSize(int width, int height) {
+    return (static_cast<size_t>(width) * height + 3) / 4;
+  }
+  // piece type of tile index of a packed grid
+  static uint8_t TypeAt(const uint8_t *grid, int index) {
+    return grid[index / 4] >> (index % 4 * kBitsPerTile) & 0x03;
+  }
+
+ private:
+  int _fd;
+  const void *_memory;
+  size_t _size;
+  int _level_count;
+};
+
+// Builds level packs, for the packer tool.
+class LevelPackWriter {
+ public:
+  // types are column major GameBoard::PieceType values below 4
+  void AddLevel(int width, int height, int goal, uint64_t seed,
+                const std::vector<uint8_t> &types);
+  bool Write(const std::string &path) const;
+  int level_count() const { return static_cast<int>(_entries.size()); }
+
+ private:
+  std::vector<LevelPack::Entry> _entries;
+  // grids one after the other, offsets are relative to the first
+  std::vector<uint8_t> _grids;
+};
+
+#endif  // SOURCE_GAME_LOGIC_LEVEL_PACK_HPP_
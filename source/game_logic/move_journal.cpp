@@ -0,0 +1,205 @@
+#include "move_journal.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+static_assert(sizeof(int) == sizeof(int32_t), "indices are stored as int32");
+
+MoveJournal::MoveJournal(size_t capacity)
+    : _ring(capacity),
+      _begin(0),
+      _cursor(0),
+      _end(0),
+      _begin_move(0),
+      _cursor_move(0),
+      _end_move(0) {}
+
+void MoveJournal::Clear() {
+  _begin = 0;
+  _cursor = 0;
+  _end = 0;
+  _begin_move = 0;
+  _cursor_move = 0;
+  _end_move = 0;
+}
+
+void MoveJournal::Append(const Record &record) {
+  // a new move replaces the undone ones
+  _end = _cursor;
+  _end_move = _cursor_move;
+
+  size_t size = EncodedSize(record);
+  if (size > _ring.size()) {
+    // too large to keep, the history before it can not be reached anymore
+    _begin = _end;
+    _begin_move = _end_move;
+    return;
+  }
+  while (_end - _begin + size > _ring.size()) {
+    DropOldestMove();
+  }
+  // the records of a dropped move are dropped with it, and so are the moves
+  // overlapping it
+  if (_begin == _end && (record.kind != kSwap || record.overlaps)) {
+    if (record.kind == kSwap) {
+      ++_end_move;
+      _begin_move = _end_move;
+      _cursor_move = _end_move;
+    }
+    return;
+  }
+
+  Encode(_end, record);
+  _end += size;
+  if (record.kind == kSwap) {
+    ++_end_move;
+  }
+  _cursor = _end;
+  _cursor_move = _end_move;
+}
+
+bool MoveJournal::StepBack(Record *record) {
+  if (_cursor == _begin) {
+    return false;
+  }
+  uint32_t size;
+  Read(_cursor - kFooterSize, &size, kFooterSize);
+  _cursor -= size;
+  Decode(_cursor, record);
+  if (record->kind == kSwap) {
+    --_cursor_move;
+  }
+  return true;
+}
+
+bool MoveJournal::StepForward(Record *record) {
+  if (_cursor == _end) {
+    return false;
+  }
+  Decode(_cursor, record);
+  _cursor += SizeAt(_cursor);
+  if (record->kind == kSwap) {
+    ++_cursor_move;
+  }
+  return true;
+}
+
+bool MoveJournal::PeekForward(Kind *kind, bool *overlaps) const {
+  if (_cursor == _end) {
+    return false;
+  }
+  *kind = KindAt(_cursor);
+  *overlaps = *kind == kSwap && OverlapsAt(_cursor);
+  return true;
+}
+
+size_t MoveJournal::EncodedSize(const Record &record) {
+  size_t size = kHeaderSize + kFooterSize;
+  if (record.kind == kSwap) {
+    size += 4 * sizeof(int32_t);
+  } else {
+    size += 2 * sizeof(uint64_t) + sizeof(uint32_t) +
+            record.deleted.size() * (sizeof(int32_t) + 2 * sizeof(uint8_t));
+  }
+  return size;
+}
+
+void MoveJournal::Encode(uint64_t position, const Record &record) {
+  auto put = [this, &position](const void *data, size_t size) {
+    Write(position, data, size);
+    position += size;
+  };
+
+  uint32_t size = EncodedSize(record);
+  put(&size, sizeof(size));
+  put(&record.kind, sizeof(record.kind));
+  if (record.kind == kSwap) {
+    int32_t swap[4] = {record.source, record.destination, record.score,
+                       record.overlaps};
+    put(swap, sizeof(swap));
+  } else {
+    uint32_t count = record.deleted.size();
+    put(&record.random_before, sizeof(record.random_before));
+    put(&record.random_after, sizeof(record.random_after));
+    put(&count, sizeof(count));
+    put(record.deleted.data(), count * sizeof(int32_t));
+    put(record.deleted_types.data(), count);
+    put(record.replacement_types.data(), count);
+  }
+  put(&size, sizeof(size));
+}
+
+void MoveJournal::Decode(uint64_t position, Record *record) const {
+  auto get = [this, &position](void *data, size_t size) {
+    Read(position, data, size);
+    position += size;
+  };
+
+  position += sizeof(uint32_t);
+  get(&record->kind, sizeof(record->kind));
+  if (record->kind == kSwap) {
+    int32_t swap[4];
+    get(swap, sizeof(swap));
+    record->source = swap[0];
+    record->destination = swap[1];
+    record->score = swap[2];
+    record->overlaps = swap[3] != 0;
+  } else {
+    uint32_t count;
+    get(&record->random_before, sizeof(record->random_before));
+    get(&record->random_after, sizeof(record->random_after));
+    get(&count, sizeof(count));
+    record->deleted.resize(count);
+    record->deleted_types.resize(count);
+    record->replacement_types.resize(count);
+    get(record->deleted.data(), count * sizeof(int32_t));
+    get(record->deleted_types.data(), count);
+    get(record->replacement_types.data(), count);
+  }
+}
+
+MoveJournal::Kind MoveJournal::KindAt(uint64_t position) const {
+  Kind kind;
+  Read(position + sizeof(uint32_t), &kind, sizeof(kind));
+  return kind;
+}
+
+bool MoveJournal::OverlapsAt(uint64_t position) const {
+  int32_t overlaps;
+  Read(position + kHeaderSize + 3 * sizeof(int32_t), &overlaps,
+       sizeof(overlaps));
+  return overlaps != 0;
+}
+
+uint32_t MoveJournal::SizeAt(uint64_t position) const {
+  uint32_t size;
+  Read(position, &size, sizeof(size));
+  return size;
+}
+
+void MoveJournal::DropOldestMove() {
+  // the records up to the next swap that does not overlap
+  do {
+    if (KindAt(_begin) == kSwap) {
+      ++_begin_move;
+    }
+    _begin += SizeAt(_begin);
+  } while (_begin != _end &&
+           (KindAt(_begin) != kSwap || OverlapsAt(_begin)));
+}
+
+void MoveJournal::Write(uint64_t position, const void *data, size_t size) {
+  const uint8_t *bytes = static_cast<const uint8_t *>(data);
+  size_t offset = position % _ring.size();
+  size_t first = std::min(size, _ring.size() - offset);
+  std::memcpy(&_ring[offset], bytes, first);
+  std::memcpy(&_ring[0], bytes + first, size - first);
+}
+
+void MoveJournal::Read(uint64_t position, void *data, size_t size) const {
+  uint8_t *bytes = static_cast<uint8_t *>(data);
+  size_t offset = position % _ring.size();
+  size_t first = std::min(size, _ring.size() - offset);
+  std::memcpy(bytes, &_ring[offset], first);
+  std::memcpy(bytes + first, &_ring[0], size - first);
+}
@@ -0,0 +1,84 @@
+#ifndef SOURCE_GAME_LOGIC_MOVE_JOURNAL_HPP_
+#define SOURCE_GAME_LOGIC_MOVE_JOURNAL_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Append only history of the piece types changed by moves, kept in a ring of
+// bytes allocated up front. A move is its swap record followed by the
+// replenish records of its deletions. A move made while the deletions of the
+// one before still ran overlaps it, their records interleave, so they are
+// only undone, redone and dropped together. Undo and redo walk the records
+// from the cursor, so they cost as much as the move changed, and once the
+// ring is full the oldest moves are dropped.
+class MoveJournal {
+ public:
+  enum Kind : uint8_t { kSwap = 0, kReplenish };
+
+  typedef struct {
+    Kind kind;
+    // kSwap, tile indices are column major like MoveSpeculator's
+    int source;
+    int destination;
+    int score;
+    // deletions of earlier moves were still running when it was made
+    bool overlaps;
+    // kReplenish, random positions around drawing the replacement types
+    uint64_t random_before;
+    uint64_t random_after;
+    // deleted tiles in column major order and their types
+    std::vector<int> deleted;
+    std::vector<uint8_t> deleted_types;
+    // types that replaced them, in the order they were drawn
+    std::vector<uint8_t> replacement_types;
+  } Record;
+
+  static constexpr size_t kDefaultCapacity = 4 << 20;
+
+  explicit MoveJournal(size_t capacity = kDefaultCapacity);
+
+  void Clear();
+  // drops the records after the cursor first
+  void Append(const Record &record);
+  // decodes the record before or after the cursor and moves over it, false
+  // when there is none
+  bool StepBack(Record *record);
+  bool StepForward(Record *record);
+  // kind of the record after the cursor and whether a swap there overlaps,
+  // false when there is none
+  bool PeekForward(Kind *kind, bool *overlaps) const;
+
+  // moves are counted from the last Clear, the cursor is after move() moves
+  int move() const { return _cursor_move; }
+  int oldest_move() const { return _begin_move; }
+  int newest_move() const { return _end_move; }
+
+ private:
+  // every record is framed by its size, so it reads in both directions
+  static constexpr size_t kHeaderSize = sizeof(uint32_t) + sizeof(uint8_t);
+  static constexpr size_t kFooterSize = sizeof(uint32_t);
+
+  static size_t EncodedSize(const Record &record);
+  void Encode(uint64_t position, const Record &record);
+  void Decode(uint64_t position, Record *record) const;
+  Kind KindAt(uint64_t position) const;
+  bool OverlapsAt(uint64_t position) const;
+  uint32_t SizeAt(uint64_t position) const;
+  // drops the oldest move and the moves overlapping it, the journal always
+  // starts with a swap that does not overlap
+  void DropOldestMove();
+  void Write(uint64_t position, const void *data, size_t size);
+  void Read(uint64_t position, void *data, size_t size) const;
+
+  std::vector<uint8_t> _ring;
+  // byte positions only grow, the ring index is the position modulo its size
+  uint64_t _begin;
+  uint64_t _cursor;
+  uint64_t _end;
+  int _begin_move;
+  int _cursor_move;
+  int _end_move;
+};
+
+#endif  // SOURCE_GAME_LOGIC_MOVE_JOURNAL_HPP_
@@ -0,0 +1,150 @@
+#include "move_speculator.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
+#include "worker_pool.hpp"
+
+MoveSpeculator::MoveSpeculator()
+    : _active(false), _version(0), _has_results(false) {}
+
+void MoveSpeculator::Start(std::vector<uint8_t> types, int width, int height,
+                           Coordinates source, uint64_t version,
+                           int blob_threshold) {
+  _active = true;
+  _source = source;
+  _version = version;
+  _has_results = false;
+  _future = WorkerPool::Global().Run(
+      [types = std::move(types), width, height, source,
+       blob_threshold]() mutable {
+        return Evaluate(std::move(types), width, height, source,
+                        blob_threshold);
+      });
+}
+
+void MoveSpeculator::Cancel() {
+  // a running evaluation finishes on its own, its result is dropped
+  _active = false;
+  _has_results = false;
+  _future = std::future<Results>();
+}
+
+bool MoveSpeculator::Matches(Coordinates source, uint64_t version) const {
+  return _active && _source == source && _version == version;
+}
+
+const MoveSpeculator::MoveResult *MoveSpeculator::Result(
+    Coordinates destination) const {
+  if (!_active || DirectionTo(destination) == kDirectionCount) {
+    return nullptr;
+  }
+  if (!_has_results) {
+    _results = _future.get();
+    _has_results = true;
+  }
+  return &_results[DirectionTo(destination)];
+}
+
+const MoveSpeculator::MoveResult *MoveSpeculator::TryResult(
+    Coordinates destination) const {
+  if (!_active || (!_has_results && _future.wait_for(std::chrono::seconds(
+                                        0)) != std::future_status::ready)) {
+    return nullptr;
+  }
+  return Result(destination);
+}
+
+MoveSpeculator::Results MoveSpeculator::Evaluate(std::vector<uint8_t> types,
+                                                 int width, int height,
+                                                 Coordinates source,
+                                                 int blob_threshold) {
+  // Same outcome as labeling the whole board after the swap, but only the
+  // blobs at the two swapped tiles are visited.
+  const std::array<Coordinates, kDirectionCount> deltas = {
+      {{0, 0}, {-1, 0}, {1, 0}, {0, -1}, {0, 1}}};
+  Results results;
+  int source_index = source.x * height + source.y;
+
+  for (int direction = 0; direction < kDirectionCount; direction++) {
+    MoveResult &result = results[direction];
+    result.score = 0;
+    Coordinates destination(source.x + deltas[direction].x,
+                            source.y + deltas[direction].y);
+    if (destination.x < 0 || destination.x >= width || destination.y < 0 ||
+        destination.y >= height) {
+      continue;
+    }
+    int destination_index = destination.x * height + destination.y;
+
+    std::swap(types[source_index], types[destination_index]);
+    std::vector<int> source_blob =
+        FloodFill(types, width, height, source_index);
+    bool same_blob =
+        std::find(source_blob.begin(), source_blob.end(), destination_index) !=
+        source_blob.end();
+    std::vector<int> destination_blob;
+    if (!same_blob) {
+      destination_blob = FloodFill(types, width, height, destination_index);
+    }
+    std::swap(types[source_index], types[destination_index]);
+
+    // a blob holding both tiles is counted for both, like a labeled move
+    int source_size = source_blob.size();
+    if (source_size >= blob_threshold) {
+      result.score += same_blob ? 2 * source_size : source_size;
+      result.deletions = std::move(source_blob);
+    }
+    int destination_size = destination_blob.size();
+    if (destination_size >= blob_threshold) {
+      result.score += destination_size;
+      result.deletions.insert(result.deletions.end(), destination_blob.begin(),
+                              destination_blob.end());
+    }
+  }
+  return results;
+}
+
+std::vector<int> MoveSpeculator::FloodFill(std::vector<uint8_t> &types,
+                                           int width, int height, int start) {
+  // visited tiles are marked in place and restored before returning
+  uint8_t type = types[start];
+  std::vector<int> blob = {start};
+  types[start] = kVisited;
+  for (size_t i = 0; i < blob.size(); i++) {
+    int index = blob[i];
+    int x = index / height;
+    int y = index % height;
+    std::array<int, 4> neighbours = {
+        {x > 0 ? index - height : -1, x < width - 1 ? index + height : -1,
+         y > 0 ? index - 1 : -1, y < height - 1 ? index + 1 : -1}};
+    for (int neighbour : neighbours) {
+      if (neighbour >= 0 && types[neighbour] == type) {
+        types[neighbour] = kVisited;
+        blob.push_back(neighbour);
+      }
+    }
+  }
+  for (int index : blob) {
+    types[index] = type;
+  }
+  return blob;
+}
+
+int MoveSpeculator::DirectionTo(Coordinates destination) const {
+  int delta_x = destination.x - _source.x;
+  int delta_y = destination.y - _source.y;
+  if (delta_x == 0 && delta_y == 0) {
+    return kStay;
+  } else if (delta_x == -1 && delta_y == 0) {
+    return kLeft;
+  } else if (delta_x == 1 && delta_y == 0) {
+    return kRight;
+  } else if (delta_x == 0 && delta_y == -1) {
+    return kDown;
+  } else if (delta_x == 0 && delta_y == 1) {
+    return kUp;
+  }
+  return kDirectionCount;
+}
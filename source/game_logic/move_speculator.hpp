@@ -0,0 +1,55 @@
+#ifndef SOURCE_GAME_LOGIC_MOVE_SPECULATOR_HPP_
+#define SOURCE_GAME_LOGIC_MOVE_SPECULATOR_HPP_
+
+#include <array>
+#include <cstdint>
+#include <future>
+#include <vector>
+
+#include "coordinates.hpp"
+
+// Evaluates the possible swaps of a dragged tile on a worker while the user is
+// still dragging. Results are only valid for the board version they were
+// started with.
+class MoveSpeculator {
+ public:
+  typedef struct {
+    int score;
+    // tiles to delete, column major indices on the board after the swap
+    std::vector<int> deletions;
+  } MoveResult;
+
+  MoveSpeculator();
+
+  void Start(std::vector<uint8_t> types, int width, int height,
+             Coordinates source, uint64_t version, int blob_threshold);
+  void Cancel();
+  bool Matches(Coordinates source, uint64_t version) const;
+
+  // Result waits for the evaluation to finish, TryResult returns nullptr
+  // while it is still running.
+  const MoveResult *Result(Coordinates destination) const;
+  const MoveResult *TryResult(Coordinates destination) const;
+
+ private:
+  // staying in place is a candidate too, it scores on existing blobs
+  enum Direction { kStay = 0, kLeft, kRight, kDown, kUp, kDirectionCount };
+  typedef std::array<MoveResult, kDirectionCount> Results;
+
+  static Results Evaluate(std::vector<uint8_t> types, int width, int height,
+                          Coordinates source, int blob_threshold);
+  static std::vector<int> FloodFill(std::vector<uint8_t> &types, int width,
+                                    int height, int start);
+  int DirectionTo(Coordinates destination) const;
+
+  static constexpr uint8_t kVisited = 0xFF;
+
+  bool _active;
+  Coordinates _source;
+  uint64_t _version;
+  mutable std::future<Results> _future;
+  mutable Results _results;
+  mutable bool _has_results;
+};
+
+#endif  // SOURCE_GAME_LOGIC_MOVE_SPECULATOR_HPP_
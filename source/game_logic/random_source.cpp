@@ -0,0 +1,83 @@
+#include "random_source.hpp"
+
+#include <cmath>
+
+RandomSource::RandomSource(uint64_t seed) { Seed(seed); }
+
+void RandomSource::Seed(uint64_t seed) {
+  _seed = seed;
+  _state = seed + kIncrement;
+  Next();
+  _position = 0;
+}
+
+void RandomSource::Seek(uint64_t position) {
+  Seed(_seed);
+  Advance(position);
+  _position = position;
+}
+
+uint32_t RandomSource::Next() {
+  uint64_t old_state = _state;
+  _state = old_state * kMultiplier + kIncrement;
+  ++_position;
+  uint32_t xorshifted = ((old_state >> 18u) ^ old_state) >> 27u;
+  uint32_t rotation = old_state >> 59u;
+  return (xorshifted >> rotation) | (xorshifted << ((-rotation) & 31));
+}
+
+uint32_t RandomSource::Uniform(uint32_t bound) {
+  // reject the low values that would bias the modulo
+  uint32_t threshold = -bound % bound;
+  while (true) {
+    uint32_t value = Next();
+    if (value >= threshold) {
+      return value % bound;
+    }
+  }
+}
+
+double RandomSource::UniformUnit() {
+  return (static_cast<double>(Next()) + 1.0) / 4294967296.0;
+}
+
+int RandomSource::Geometric(double chance) {
+  return static_cast<int>(std::log(UniformUnit()) / std::log1p(-chance));
+}
+
+void RandomSource::FillTypes(uint8_t *out, int count, int type_count) {
+  if (type_count > 4 || (type_count & (type_count - 1)) != 0) {
+    for (int i = 0; i < count; i++) {
+      out[i] = Uniform(type_count);
+    }
+    return;
+  }
+
+  // two bits per value, masked down when there are fewer types
+  uint32_t mask = type_count - 1;
+  for (int i = 0; i < count; i += 16) {
+    uint32_t bits = Next();
+    for (int j = i; j < i + 16 && j < count; j++) {
+      out[j] = bits & mask;
+      bits >>= 2;
+    }
+  }
+}
+
+void RandomSource::Advance(uint64_t delta) {
+  // jump ahead by composing the linear congruential step delta times
+  uint64_t multiplier = kMultiplier;
+  uint64_t increment = kIncrement;
+  uint64_t accumulated_multiplier = 1;
+  uint64_t accumulated_increment = 0;
+  while (delta > 0) {
+    if (delta & 1) {
+      accumulated_multiplier *= multiplier;
+      accumulated_increment = accumulated_increment * multiplier + increment;
+    }
+    increment = (multiplier + 1) * increment;
+    multiplier *= multiplier;
+    delta /= 2;
+  }
+  _state = accumulated_multiplier * _state + accumulated_increment;
+}
@@ -0,0 +1,42 @@
+#ifndef SOURCE_GAME_LOGIC_RANDOM_SOURCE_HPP_
+#define SOURCE_GAME_LOGIC_RANDOM_SOURCE_HPP_
+
+#include <cstdint>
+
+// PCG32 random number generator. Every 32 bit output advances the position
+// by one, and any position can be returned to in logarithmic time, which
+// makes runs reproducible from the seed and a position alone.
+class RandomSource {
+ public:
+  explicit RandomSource(uint64_t seed = kDefaultSeed);
+
+  void Seed(uint64_t seed);
+  void Seek(uint64_t position);
+  uint64_t seed() const { return _seed; }
+  uint64_t position() const { return _position; }
+
+  uint32_t Next();
+  // uniform in [0, bound)
+  uint32_t Uniform(uint32_t bound);
+  // uniform in (0, 1]
+  double UniformUnit();
+  // number of failed trials before the first success with the given chance
+  int Geometric(double chance);
+  // fills out with values in [0, type_count), 16 per output when type_count
+  // is 4 or less and a power of two
+  void FillTypes(uint8_t *out, int count, int type_count);
+
+  static constexpr uint64_t kDefaultSeed = 0x853c49e6748fea9bULL;
+
+ private:
+  void Advance(uint64_t delta);
+
+  static constexpr uint64_t kMultiplier = 6364136223846793005ULL;
+  static constexpr uint64_t kIncrement = 1442695040888963407ULL;
+
+  uint64_t _seed;
+  uint64_t _state;
+  uint64_t _position;
+};
+
+#endif  // SOURCE_GAME_LOGIC_RANDOM_SOURCE_HPP_
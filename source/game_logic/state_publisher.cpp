@@ -0,0 +1,285 @@
+#include "state_publisher.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+#if !defined(__ANDROID__) && !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define TUX_MATCH_SHARED_MEMORY
+#endif
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free &&
+                  std::atomic<uint32_t>::is_always_lock_free,
+              "atomics in shared memory must be lock free");
+
+namespace {
+// slots start on their own cache line, so writing one leaves the other alone
+constexpr size_t kAlignment = 64;
+constexpr uint64_t kNoVersion = ~0ull;
+
+size_t RoundUp(size_t size) {
+  return (size + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+size_t HeaderSize() { return RoundUp(sizeof(StatePublisher::Header)); }
+}  // namespace
+
+StatePublisher::StatePublisher()
+    : _fd(-1),
+      _memory(nullptr),
+      _size(0),
+      _slot_size(0),
+      _tick(0),
+      _layout_pending(false) {}
+
+#ifdef TUX_MATCH_SHARED_MEMORY
+
+StatePublisher::~StatePublisher() {
+  if (_memory != nullptr) {
+    munmap(_memory, _size);
+  }
+  if (_fd >= 0) {
+    close(_fd);
+    shm_unlink(_name.c_str());
+  }
+}
+
+bool StatePublisher::Open(const std::string &name) {
+  _fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (_fd < 0) {
+    std::cerr << "could not create shared memory " << name << ": "
+              << std::strerror(errno) << std::endl;
+    return false;
+  }
+  _name = name;
+  if (!Layout(kInitialTiles)) {
+    return false;
+  }
+  // the segment starts out zeroed, so nothing is published yet
+  Header *header = static_cast<Header *>(_memory);
+  header->magic = kMagic;
+  header->layout_version = kLayoutVersion;
+  return true;
+}
+
+bool StatePublisher::Layout(size_t tiles) {
+  // room for twice the tiles, so boards growing by level rarely lay out again
+  size_t slot_size = RoundUp(sizeof(Slot) + 2 * tiles);
+  size_t size = HeaderSize() + 2 * slot_size;
+  if (size > _size) {
+    void *memory = MAP_FAILED;
+    if (ftruncate(_fd, size) == 0) {
+      memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+    }
+    if (memory == MAP_FAILED) {
+      std::cerr << "could not map shared memory " << _name << ": "
+                << std::strerror(errno) << std::endl;
+      return false;
+    }
+    if (_memory != nullptr) {
+      munmap(_memory, _size);
+    }
+    _memory = memory;
+    _size = size;
+  }
+
+  Header *header = static_cast<Header *>(_memory);
+  header->segment_size.store(_size, std::memory_order_relaxed);
+  header->slot_size.store(slot_size, std::memory_order_relaxed);
+  _slot_size = slot_size;
+  for (uint32_t index = 0; index < 2; index++) {
+    Slot *slot = SlotAt(index);
+    slot->sequence.store(0, std::memory_order_relaxed);
+    slot->board_version = kNoVersion;
+  }
+  return true;
+}
+
+#else
+
+StatePublisher::~StatePublisher() {}
+
+bool StatePublisher::Open(const std::string &name) {
+  std::cerr << "shared memory is not available for " << name << std::endl;
+  return false;
+}
+
+bool StatePublisher::Layout(size_t) { return false; }
+
+#endif  // TUX_MATCH_SHARED_MEMORY
+
+void StatePublisher::Publish(const GameBoard &board, int score, int goal,
+                             int state) {
+  if (_memory == nullptr) {
+    return;
+  }
+  Header *header = static_cast<Header *>(_memory);
+  size_t tiles = static_cast<size_t>(board.width()) * board.height();
+  if (sizeof(Slot) + tiles > _slot_size) {
+    // readers retry until the new layout holds a complete state
+    header->generation.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    if (!Layout(tiles)) {
+      header = static_cast<Header *>(_memory);
+      header->generation.fetch_add(1, std::memory_order_release);
+      return;
+    }
+    header = static_cast<Header *>(_memory);
+    _layout_pending = true;
+  }
+
+  // the latest slot stays as it is for the readers, the other one is written
+  uint32_t index = 1 - header->latest.load(std::memory_order_relaxed);
+  Slot *slot = SlotAt(index);
+  uint64_t sequence = slot->sequence.load(std::memory_order_relaxed);
+  slot->sequence.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  slot->tick = _tick++;
+  slot->score = score;
+  slot->goal = goal;
+  slot->state = state;
+  if (slot->board_version != board.version() ||
+      slot->width != board.width() || slot->height != board.height()) {
+    uint8_t *types = reinterpret_cast<uint8_t *>(slot + 1);
+    for (int x = 0; x < board.width(); x++) {
+      const GameBoard::BoardTile *column = board.column(x);
+      for (int y = 0; y < board.height(); y++) {
+        *types++ = column[y].type();
+      }
+    }
+    slot->board_version = board.version();
+    slot->width = board.width();
+    slot->height = board.height();
+  }
+
+  slot->sequence.store(sequence + 2, std::memory_order_release);
+  header->latest.store(index, std::memory_order_release);
+  if (_layout_pending) {
+    header->generation.fetch_add(1, std::memory_order_release);
+    _layout_pending = false;
+  }
+}
+
+StatePublisher::Slot *StatePublisher::SlotAt(uint32_t index) {
+  char *slots = static_cast<char *>(_memory) + HeaderSize();
+  return reinterpret_cast<Slot *>(slots + index * _slot_size);
+}
+
+StateReader::StateReader() : _fd(-1), _memory(nullptr), _size(0) {}
+
+#ifdef TUX_MATCH_SHARED_MEMORY
+
+StateReader::~StateReader() {
+  if (_memory != nullptr) {
+    munmap(const_cast<void *>(_memory), _size);
+  }
+  if (_fd >= 0) {
+    close(_fd);
+  }
+}
+
+bool StateReader::Open(const std::string &name) {
+  _fd = shm_open(name.c_str(), O_RDONLY, 0);
+  if (_fd < 0 || !Map()) {
+    std::cerr << "could not open shared memory " << name << ": "
+              << std::strerror(errno) << std::endl;
+    return false;
+  }
+  const Header *header = static_cast<const Header *>(_memory);
+  if (_size < HeaderSize() || header->magic != StatePublisher::kMagic ||
+      header->layout_version != StatePublisher::kLayoutVersion) {
+    std::cerr << name << " holds no published state" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool StateReader::Map() {
+  struct stat status;
+  if (fstat(_fd, &status) != 0) {
+    return false;
+  }
+  size_t size = status.st_size;
+  void *memory = mmap(nullptr, size, PROT_READ, MAP_SHARED, _fd, 0);
+  if (memory == MAP_FAILED) {
+    return false;
+  }
+  if (_memory != nullptr) {
+    munmap(const_cast<void *>(_memory), _size);
+  }
+  _memory = memory;
+  _size = size;
+  return true;
+}
+
+#else
+
+StateReader::~StateReader() {}
+
+bool StateReader::Open(const std::string &name) {
+  std::cerr << "shared memory is not available for " << name << std::endl;
+  return false;
+}
+
+bool StateReader::Map() { return false; }
+
+#endif  // TUX_MATCH_SHARED_MEMORY
+
+bool StateReader::Read(
+    const std::function<void(const Slot &slot, const uint8_t *types)> &read) {
+  if (_memory == nullptr) {
+    return false;
+  }
+  while (true) {
+    const Header *header = static_cast<const Header *>(_memory);
+    uint64_t generation = header->generation.load(std::memory_order_acquire);
+    if (generation % 2 == 1) {
+      std::this_thread::yield();
+      continue;
+    }
+    if (header->segment_size.load(std::memory_order_relaxed) > _size) {
+      if (!Map()) {
+        return false;
+      }
+      continue;
+    }
+
+    // a layout of a newer generation may not fit the mapping yet
+    size_t slot_size = header->slot_size.load(std::memory_order_relaxed);
+    uint32_t index = header->latest.load(std::memory_order_acquire);
+    if (index > 1 || HeaderSize() + 2 * slot_size > _size) {
+      continue;
+    }
+    const char *slots = static_cast<const char *>(_memory) + HeaderSize();
+    const Slot *slot =
+        reinterpret_cast<const Slot *>(slots + index * slot_size);
+    uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+    if (sequence == 0 &&
+        header->generation.load(std::memory_order_relaxed) == generation) {
+      return false;
+    }
+
+    // sizes of a torn slot may be anything
+    bool complete = sequence % 2 == 0 && slot->width >= 0 &&
+                    slot->height >= 0 &&
+                    sizeof(Slot) + static_cast<size_t>(slot->width) *
+                                       slot->height <=
+                        slot_size;
+    if (complete) {
+      read(*slot, reinterpret_cast<const uint8_t *>(slot + 1));
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (complete &&
+        slot->sequence.load(std::memory_order_relaxed) == sequence &&
+        header->generation.load(std::memory_order_relaxed) == generation) {
+      return true;
+    }
+    std::this_thread::yield();
+  }
+}
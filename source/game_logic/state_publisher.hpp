@@ -0,0 +1,106 @@
+#ifndef SOURCE_GAME_LOGIC_STATE_PUBLISHER_HPP_
+#define SOURCE_GAME_LOGIC_STATE_PUBLISHER_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include "game_board.hpp"
+
+// Publishes the state of a game into a named POSIX shared memory segment,
+// for local observers like stream overlays and bots. The segment starts with
+// a Header, followed by two slots that are written in turn. A slot's sequence
+// is odd while it is written and the header's generation is odd while the
+// slots are laid out again, so readers check both before and after reading in
+// place and retry when either changed. Readers never block the publisher.
+// The segment is removed again when the publisher is destroyed.
+class StatePublisher {
+ public:
+  static constexpr uint32_t kMagic = 0x53584D54;  // "TMXS"
+  static constexpr uint32_t kLayoutVersion = 1;
+
+  typedef struct {
+    uint32_t magic;
+    uint32_t layout_version;
+    std::atomic<uint64_t> generation;
+    // grows with the board, readers map the segment again when it did
+    std::atomic<uint64_t> segment_size;
+    // bytes per slot, including the piece types
+    std::atomic<uint64_t> slot_size;
+    // slot holding the newest complete state
+    std::atomic<uint32_t> latest;
+    uint32_t padding;
+  } Header;
+
+  typedef struct {
+    std::atomic<uint64_t> sequence;
+    // physics ticks published before this one
+    uint64_t tick;
+    // GameBoard::version of the piece types
+    uint64_t board_version;
+    int32_t score;
+    int32_t goal;
+    // GameLogic::GameState
+    int32_t state;
+    int32_t width;
+    int32_t height;
+    int32_t padding;
+    // followed by width * height GameBoard::PieceType bytes, column major
+  } Slot;
+
+  StatePublisher();
+  ~StatePublisher();
+
+  // name starts with a slash, like /tux_match
+  bool Open(const std::string &name);
+  // piece types are only copied when the slot holds another board version
+  void Publish(const GameBoard &board, int score, int goal, int state);
+
+ private:
+  // sizes the segment for slots of at least tiles piece types and clears
+  // them, readers have to be kept out by an odd generation
+  bool Layout(size_t tiles);
+  Slot *SlotAt(uint32_t index);
+
+  // piece types the first layout holds, slots grow along with the boards
+  static constexpr size_t kInitialTiles = 64 * 64;
+
+  std::string _name;
+  int _fd;
+  void *_memory;
+  size_t _size;
+  size_t _slot_size;
+  uint64_t _tick;
+  // the generation is odd until a slot of the new layout is written
+  bool _layout_pending;
+};
+
+// Maps a segment of a StatePublisher read only, from any process.
+class StateReader {
+ public:
+  StateReader();
+  ~StateReader();
+
+  bool Open(const std::string &name);
+  // Calls read with the newest complete slot and its piece types, in place.
+  // When the publisher overwrote them meanwhile read is called again, so it
+  // must only look at the state and not act on it yet. Returns false when
+  // nothing was published yet.
+  bool Read(const std::function<void(const StatePublisher::Slot &slot,
+                                     const uint8_t *types)> &read);
+
+ private:
+  typedef StatePublisher::Header Header;
+  typedef StatePublisher::Slot Slot;
+
+  // maps the whole segment again, it may have grown since
+  bool Map();
+
+  int _fd;
+  const void *_memory;
+  size_t _size;
+};
+
+#endif  // SOURCE_GAME_LOGIC_STATE_PUBLISHER_HPP_
@@ -0,0 +1,82 @@
+#include "timing_wheel.hpp"
+
+#include <algorithm>
+#include <utility>
+
+TimingWheel::TimingWheel(uint64_t now) : _now(now), _size(0) {}
+
+void TimingWheel::Clear() {
+  for (auto &level : _slots) {
+    for (auto &slot : level) {
+      slot.clear();
+    }
+  }
+  _overflow.clear();
+  _due.clear();
+  _size = 0;
+}
+
+void TimingWheel::Schedule(const Event &event) {
+  ++_size;
+  if (event.tick <= _now) {
+    _due.push_back(event);
+  } else {
+    Insert(event);
+  }
+}
+
+void TimingWheel::Advance(uint64_t tick, std::vector<Event> *fired) {
+  fired->insert(fired->end(), _due.begin(), _due.end());
+  _size -= _due.size();
+  _due.clear();
+  while (_now < tick && _size > 0) {
+    ++_now;
+    // higher levels first, their events may land in the slots below
+    for (int level = kLevels; level > 0; level--) {
+      uint64_t span_mask = (uint64_t(1) << (level * kSlotBits)) - 1;
+      if ((_now & span_mask) == 0) {
+        Cascade(level);
+      }
+    }
+    std::vector<Event> &slot = _slots[0][_now & (kSlots - 1)];
+    fired->insert(fired->end(), slot.begin(), slot.end());
+    _size -= slot.size();
+    slot.clear();
+  }
+  // nothing left to fire, skip the empty slots
+  _now = std::max(_now, tick);
+}
+
+int TimingWheel::LevelOf(uint64_t tick) const {
+  // the events of a level share the span of the level above with now
+  int level = 0;
+  int shift = kSlotBits;
+  while (level < kLevels && tick >> shift != _now >> shift) {
+    ++level;
+    shift += kSlotBits;
+  }
+  return level;
+}
+
+void TimingWheel::Insert(const Event &event) {
+  int level = LevelOf(event.tick);
+  if (level == kLevels) {
+    _overflow.push_back(event);
+    return;
+  }
+  _slots[level][(event.tick >> (level * kSlotBits)) & (kSlots - 1)].push_back(
+      event);
+}
+
+void TimingWheel::Cascade(int level) {
+  _cascading.clear();
+  if (level == kLevels) {
+    std::swap(_cascading, _overflow);
+  } else {
+    std::swap(_cascading,
+              _slots[level][(_now >> (level * kSlotBits)) & (kSlots - 1)]);
+  }
+  for (const Event &event : _cascading) {
+    Insert(event);
+  }
+}
@@ -0,0 +1,60 @@
+#ifndef SOURCE_GAME_LOGIC_TIMING_WHEEL_HPP_
+#define SOURCE_GAME_LOGIC_TIMING_WHEEL_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Hierarchical timing wheel of events keyed by tick. The lowest level has a
+// slot per tick of the current kSlots ticks, every level above has slots
+// kSlots times as wide, and events move down a level whenever their slot comes
+// up. Scheduling is constant time and advancing costs a slot per tick plus the
+// events due. Events are never cancelled, owners stamp them and ignore the
+// outdated ones. Slots keep their capacity, so a steady workload does not
+// allocate once warm.
+class TimingWheel {
+ public:
+  typedef struct {
+    uint64_t tick;
+    // chosen by the owner, like a tile index
+    int key;
+    uint32_t stamp;
+  } Event;
+
+  explicit TimingWheel(uint64_t now = 0);
+
+  // drops every event, time stays as it is
+  void Clear();
+  // events due at or before now fire with the next Advance
+  void Schedule(const Event &event);
+  // moves time forward to tick and appends the events due by then to fired,
+  // in order of their ticks
+  void Advance(uint64_t tick, std::vector<Event> *fired);
+
+  uint64_t now() const { return _now; }
+  size_t size() const { return _size; }
+
+ private:
+  static constexpr int kSlotBits = 6;
+  static constexpr int kSlots = 1 << kSlotBits;
+  static constexpr int kLevels = 3;
+
+  // level holding tick from now, kLevels for the overflow
+  int LevelOf(uint64_t tick) const;
+  void Insert(const Event &event);
+  // moves the events of the slot that came up on level down
+  void Cascade(int level);
+
+  uint64_t _now;
+  size_t _size;
+  std::array<std::array<std::vector<Event>, kSlots>, kLevels> _slots;
+  // events beyond the top level, sorted in again when it wraps around
+  std::vector<Event> _overflow;
+  // events scheduled at or before now
+  std::vector<Event> _due;
+  // scratch of Cascade
+  std::vector<Event> _cascading;
+};
+
+#endif  // SOURCE_GAME_LOGIC_TIMING_WHEEL_HPP_
@@ -0,0 +1,109 @@
+#include "worker_pool.hpp"
+
+#include <algorithm>
+
+WorkerPool::WorkerPool(int thread_count)
+    : _tasks(&_memory), _stopping(false) {
+  for (int i = 0; i < thread_count; i++) {
+    _threads.emplace_back(&WorkerPool::WorkerLoop, this);
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stopping = true;
+  }
+  _condition.notify_all();
+  for (auto &thread : _threads) {
+    thread.join();
+  }
+}
+
+WorkerPool &WorkerPool::Global() {
+  static WorkerPool pool(
+      std::max(1, static_cast<int>(std::thread::hardware_concurrency())));
+  return pool;
+}
+
+void WorkerPool::ParallelFor(int count, const std::function<void(int)> &task) {
+  if (count <= 1 || _threads.empty()) {
+    for (int i = 0; i < count; i++) {
+      task(i);
+    }
+    return;
+  }
+
+  // Indices are claimed from a shared counter, so helpers that only get to
+  // run after the caller finished everything simply return. The callbacks
+  // only capture pointers, which std::function stores without allocating.
+  std::pmr::polymorphic_allocator<ParallelForState> allocator(&_memory);
+  ParallelForState *state = allocator.allocate(1);
+  allocator.construct(state);
+  int helpers = std::min(count - 1, size());
+  state->count = count;
+  state->task = &task;
+  state->users = helpers + 1;
+  for (int i = 0; i < helpers; i++) {
+    // the reference to task stays valid, helpers only call it for claimed
+    // indices and those are waited for below
+    Enqueue([this, state]() {
+      RunParallelFor(state);
+      ReleaseParallelFor(state);
+    });
+  }
+  RunParallelFor(state);
+
+  {
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->condition.wait(lock, [state]() {
+      return state->done == state->count;
+    });
+  }
+  ReleaseParallelFor(state);
+}
+
+void WorkerPool::RunParallelFor(ParallelForState *state) {
+  int finished = 0;
+  for (int i = state->next++; i < state->count; i = state->next++) {
+    (*state->task)(i);
+    ++finished;
+  }
+  if (finished > 0) {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    state->done += finished;
+    state->condition.notify_all();
+  }
+}
+
+void WorkerPool::ReleaseParallelFor(ParallelForState *state) {
+  if (state->users.fetch_sub(1) == 1) {
+    std::pmr::polymorphic_allocator<ParallelForState> allocator(&_memory);
+    state->~ParallelForState();
+    allocator.deallocate(state, 1);
+  }
+}
+
+void WorkerPool::Enqueue(std::function<void()> task) {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _tasks.push_back(std::move(task));
+  }
+  _condition.notify_one();
+}
+
+void WorkerPool::WorkerLoop() {
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _condition.wait(lock, [this]() { return _stopping || !_tasks.empty(); });
+      if (_stopping && _tasks.empty()) {
+        return;
+      }
+      task = std::move(_tasks.front());
+      _tasks.pop_front();
+    }
+    task();
+  }
+}
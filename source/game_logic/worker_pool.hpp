@@ -0,0 +1,68 @@
+#ifndef SOURCE_GAME_LOGIC_WORKER_POOL_HPP_
+#define SOURCE_GAME_LOGIC_WORKER_POOL_HPP_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads for the game logic background work.
+class WorkerPool {
+ public:
+  explicit WorkerPool(int thread_count);
+  ~WorkerPool();
+
+  // shared pool with one thread per core
+  static WorkerPool &Global();
+
+  int size() const { return static_cast<int>(_threads.size()); }
+
+  template <typename Function>
+  auto Run(Function function) -> std::future<decltype(function())> {
+    typedef decltype(function()) Result;
+    auto task = std::make_shared<std::packaged_task<Result()>>(
+        std::move(function));
+    auto future = task->get_future();
+    Enqueue([task]() { (*task)(); });
+    return future;
+  }
+
+  // Calls task for every index in [0, count) on the workers and the calling
+  // thread, and returns once all calls are done. Safe to use from a worker.
+  void ParallelFor(int count, const std::function<void(int)> &task);
+
+ private:
+  // shared by the caller and the helpers of one ParallelFor, freed by the
+  // last one done with it
+  struct ParallelForState {
+    std::atomic<int> next{0};
+    std::atomic<int> users{0};
+    int count = 0;
+    const std::function<void(int)> *task = nullptr;
+    int done = 0;
+    std::mutex mutex;
+    std::condition_variable condition;
+  };
+
+  void Enqueue(std::function<void()> task);
+  void WorkerLoop();
+  void RunParallelFor(ParallelForState *state);
+  void ReleaseParallelFor(ParallelForState *state);
+
+  std::vector<std::thread> _threads;
+  // recycles the queue blocks and ParallelFor states, so steady use does not
+  // touch the heap
+  std::pmr::synchronized_pool_resource _memory;
+  std::pmr::deque<std::function<void()>> _tasks;
+  std::mutex _mutex;
+  std::condition_variable _condition;
+  bool _stopping;
+};
+
+#endif  // SOURCE_GAME_LOGIC_WORKER_POOL_HPP_
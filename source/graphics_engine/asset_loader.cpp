@@ -0,0 +1,107 @@
+#include "asset_loader.hpp"
+
+#include <QFile>
+#include <QOpenGLContext>
+
+#include "game_logic/worker_pool.hpp"
+
+void AssetLoader::Start(const QStringList &image_paths,
+                        const QStringList &shader_paths) {
+  WorkerPool &pool = WorkerPool::Global();
+  for (const QString &path : image_paths) {
+    _images[path] = pool.Run([path]() {
+      // convert here, so the upload does not have to
+      return QImage(path).convertToFormat(QImage::Format_RGBA8888);
+    });
+  }
+  for (const QString &path : shader_paths) {
+    _shader_sources[path] = pool.Run([path]() {
+      QFile file(path);
+      file.open(QIODevice::ReadOnly);
+      return file.readAll();
+    });
+  }
+}
+
+bool AssetLoader::Ready() const {
+  for (const auto &image : _images) {
+    if (!IsReady(image.second)) {
+      return false;
+    }
+  }
+  for (const auto &source : _shader_sources) {
+    if (!IsReady(source.second)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool AssetLoader::Ready(const QStringList &paths) const {
+  for (const QString &path : paths) {
+    auto image = _images.find(path);
+    if (image != _images.end() && !IsReady(image->second)) {
+      return false;
+    }
+    auto source = _shader_sources.find(path);
+    if (source != _shader_sources.end() && !IsReady(source->second)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+QImage AssetLoader::Image(const QString &path) {
+  auto image = _images.find(path);
+  if (image == _images.end()) {
+    // not requested up front, load it here
+    return QImage(path);
+  }
+  return image->second.get();
+}
+
+QByteArray AssetLoader::ShaderSource(const QString &path) {
+  auto source = _shader_sources.find(path);
+  if (source == _shader_sources.end()) {
+    QFile file(path);
+    file.open(QIODevice::ReadOnly);
+    return file.readAll();
+  }
+  return source->second.get();
+}
+
+QOpenGLTexture *AssetLoader::CreateTexture(const QString &path) {
+  QOpenGLTexture *texture = new QOpenGLTexture(Image(path));
+  texture->setMinificationFilter(QOpenGLTexture::Linear);
+  texture->setMagnificationFilter(QOpenGLTexture::Linear);
+  texture->setWrapMode(QOpenGLTexture::Repeat);
+  return texture;
+}
+
+bool AssetLoader::BuildProgram(
+    QOpenGLShaderProgram &program, const QString &vs_path,
+    const QString &fs_path,
+    const std::vector<const char *> &feedback_varyings) {
+  QByteArray vs_source = ShaderSource(vs_path);
+  QByteArray fs_source = ShaderSource(fs_path);
+
+  if (QOpenGLContext::currentContext()->isOpenGLES()) {
+    vs_source.prepend(QByteArrayLiteral("#version 300 es\n"));
+    fs_source.prepend(QByteArrayLiteral("#version 300 es\n"));
+  } else {
+    vs_source.prepend(QByteArrayLiteral("#version 410\n"));
+    fs_source.prepend(QByteArrayLiteral("#version 410\n"));
+  }
+
+  program.addShaderFromSourceCode(QOpenGLShader::Vertex, vs_source);
+  program.addShaderFromSourceCode(QOpenGLShader::Fragment, fs_source);
+  if (!feedback_varyings.empty()) {
+    QOpenGLContext::currentContext()
+        ->extraFunctions()
+        ->glTransformFeedbackVaryings(program.programId(),
+                                      feedback_varyings.size(),
+                                      feedback_varyings.data(),
+                                      GL_INTERLEAVED_ATTRIBS);
+  }
+  return program.link();
+}
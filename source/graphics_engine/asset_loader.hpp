@@ -0,0 +1,47 @@
+#ifndef SOURCE_GRAPHICS_ENGINE_ASSET_LOADER_HPP_
+#define SOURCE_GRAPHICS_ENGINE_ASSET_LOADER_HPP_
+
+#include <QByteArray>
+#include <QImage>
+#include <QOpenGLShaderProgram>
+#include <QOpenGLTexture>
+#include <QString>
+#include <QStringList>
+#include <chrono>
+#include <future>
+#include <map>
+#include <vector>
+
+// Decodes images and reads shader sources on the worker pool, so that the
+// work overlaps with window and GL context creation. The GL side, uploading
+// textures and compiling programs, happens on the GUI thread once an asset
+// is needed.
+class AssetLoader {
+ public:
+  void Start(const QStringList &image_paths, const QStringList &shader_paths);
+
+  // true once every requested asset is available, does not block
+  bool Ready() const;
+  bool Ready(const QStringList &paths) const;
+
+  // these block until the asset is available
+  QImage Image(const QString &path);
+  QByteArray ShaderSource(const QString &path);
+  QOpenGLTexture *CreateTexture(const QString &path);
+  // feedback_varyings are captured interleaved by transform feedback
+  bool BuildProgram(QOpenGLShaderProgram &program, const QString &vs_path,
+                    const QString &fs_path,
+                    const std::vector<const char *> &feedback_varyings = {});
+
+ private:
+  template <typename T>
+  static bool IsReady(const std::shared_future<T> &future) {
+    return future.wait_for(std::chrono::seconds(0)) ==
+           std::future_status::ready;
+  }
+
+  std::map<QString, std::shared_future<QImage>> _images;
+  std::map<QString, std::shared_future<QByteArray>> _shader_sources;
+};
+
+#endif  // SOURCE_GRAPHICS_ENGINE_ASSET_LOADER_HPP_
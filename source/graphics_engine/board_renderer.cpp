@@ -1,215 +1,436 @@
 #include "board_renderer.hpp"
 
 #include <QTemporaryFile>
-
-BoardRenderer::BoardRenderer() { Q_INIT_RESOURCE(GL_shaders); }
+#include <algorithm>
+#include <cstddef>
+
+BoardRenderer::BoardRenderer()
+    : _width(0),
+      _height(0),
+      _render_path(kAuto),
+      _use_type_map(false),
+      _static_version(0),
+      _uploaded_bytes(0),
+      _view(0),
+      _resources(nullptr),
+      _type_map_texture(0),
+      _deletion_version(0) {}
 
 BoardRenderer::~BoardRenderer() {}
 
-void BoardRenderer::Init() {
+void BoardRenderer::Init(BoardResources &resources, int view) {
   initializeOpenGLFunctions();
 
-  LoadTextures();
-  CompileShaders();
-  GenerateBuffers();
+  _resources = &resources;
+  _view = view;
+  GenerateTypeMapBuffers();
+  _particles.Init(&resources.program_particles());
+}
+
+void BoardRenderer::Render(const GameBoard &board, const Camera &camera,
+                           RenderQueue &queue) {
+  Update(board, camera);
+  RenderStatic(queue);
+  RenderDynamic(board, camera, queue);
 }
 
-void BoardRenderer::Render(const GameBoard &board) {
+void BoardRenderer::Update(const GameBoard &board, const Camera &camera) {
   int new_width = board.width();
   int new_height = board.height();
+  bool static_changed = false;
   if (new_width != _width || new_height != _height) {
-    RebuildBoardVertexBuffer(new_width, new_height);
+    GenerateChunks(new_width, new_height);
+    GenerateTypeMap(new_width, new_height);
     _width = new_width;
     _height = new_height;
+    static_changed = true;
+  }
+
+  QMatrix4x4 transform = _projection_matrix * camera.view_matrix();
+  if (transform != _transform) {
+    _transform = transform;
+    static_changed = true;
   }
 
-  RebuildBoardParamsBuffer(board);
+  bool use_type_map = UseTypeMap(board, camera);
+  if (use_type_map != _use_type_map) {
+    _use_type_map = use_type_map;
+    static_changed = true;
+  }
 
-  glBindVertexArray(_board_vao);
-  _program_board.bind();
-  _program_board.setUniformValue("transform", _projection_matrix);
-  _pieces_texture->bind(GL_TEXTURE0);
-  glDrawArrays(GL_TRIANGLES, 0, _vertex_count);
-  _pieces_texture->release();
-  _program_board.release();
-  glBindVertexArray(0);
+  if (_use_type_map && UpdateTypeMap(board)) {
+    static_changed = true;
+  }
+
+  if (static_changed) {
+    ++_static_version;
+  }
+
+  if (board.deletion_version() != _deletion_version) {
+    _deletion_version = board.deletion_version();
+    EmitDeletions(board);
+  }
+}
+
+void BoardRenderer::RenderStatic(RenderQueue &queue) {
+  if (_use_type_map) {
+    queue.SetView(_view, _transform, _clip);
+    RenderTypeMap(queue);
+  }
+}
+
+void BoardRenderer::RenderDynamic(const GameBoard &board, const Camera &camera,
+                                  RenderQueue &queue) {
+  queue.SetView(_view, _transform, _clip);
+  if (_use_type_map) {
+    RenderMovingTiles(queue);
+  } else {
+    RenderChunked(board, camera, queue);
+  }
+  _particles.Render(_transform, _resources->pieces_texture(), _view, queue);
 }
 
-void BoardRenderer::SetProjection(const QMatrix4x4 &projection_matrix) {
+void BoardRenderer::SetProjection(const QMatrix4x4 &projection_matrix,
+                                  const QRectF &clip) {
   _projection_matrix = projection_matrix;
+  if (clip != _clip) {
+    _clip = clip;
+    ++_static_version;
+  }
 }
 
-float BoardRenderer::Remap(float min_old, float max_old, float min_new,
-                           float max_new, float value) {
-  return (min_new +
-          (value - min_old) * (max_new - min_new) / (max_old - min_old));
+void BoardRenderer::SetRenderPath(RenderPath render_path) {
+  _render_path = render_path;
 }
 
-void BoardRenderer::LoadTextures() {
-  _pieces_texture = new QOpenGLTexture(QImage(":/images/pieces.png"));
-  _pieces_texture->setMinificationFilter(QOpenGLTexture::Linear);
-  _pieces_texture->setMagnificationFilter(QOpenGLTexture::Linear);
-  _pieces_texture->setWrapMode(QOpenGLTexture::Repeat);
+bool BoardRenderer::UseTypeMap(const GameBoard &board,
+                               const Camera &camera) const {
+  // the board is stored transposed, one texture row per board column
+  if (board.width() > _resources->max_texture_size() ||
+      board.height() > _resources->max_texture_size()) {
+    return false;
+  }
 
-  // build piece coords map
-  float piece_width = 1.0f / 4;
-  _piece_texture_coords[GameBoard::kChameleon].begin = piece_width * 0;
-  _piece_texture_coords[GameBoard::kChameleon].end = piece_width * 1;
-  _piece_texture_coords[GameBoard::kTux].begin = piece_width * 1;
-  _piece_texture_coords[GameBoard::kTux].end = piece_width * 2;
-  _piece_texture_coords[GameBoard::kHat].begin = piece_width * 2;
-  _piece_texture_coords[GameBoard::kHat].end = piece_width * 3;
-  _piece_texture_coords[GameBoard::kWildebeest].begin = piece_width * 3;
-  _piece_texture_coords[GameBoard::kWildebeest].end = piece_width * 4;
+  switch (_render_path) {
+    case kChunked: {
+      return false;
+    }
+    case kTypeMap: {
+      return true;
+    }
+    case kAuto: {
+      QRectF visible_rect = camera.visible_rect();
+      float board_tiles = board.width() * board.height();
+      float visible_tiles = visible_rect.width() * visible_rect.height();
+      return std::min(board_tiles, visible_tiles) > kTypeMapTileThreshold;
+    }
+  }
+  return false;
 }
 
-void BoardRenderer::GenerateBuffers() {
-  glGenVertexArrays(1, &_board_vao);
-  glGenBuffers(1, &_board_vertex_vbo);
-  glGenBuffers(1, &_board_params_vbo);
+void BoardRenderer::EmitDeletions(const GameBoard &board) {
+  // large combos burst from an even subset of the deleted tiles
+  const std::vector<Coordinates> &deletions = board.deletions();
+  size_t stride = (deletions.size() + ParticleSystem::kMaxEmitters - 1) /
+                  ParticleSystem::kMaxEmitters;
+  for (size_t i = 0; i < deletions.size(); i += stride) {
+    const Coordinates &pos = deletions[i];
+    GameBoard::PieceType type = board.tile(pos.x, pos.y).type();
+    uint8_t atlas_cell = _resources->atlas_cell(type);
+    _particles.Emit(QVector4D(pos.x, pos.y, atlas_cell, 0.0f));
+  }
+}
 
-  glBindVertexArray(_board_vao);
-  // vertex buffer
-  glBindBuffer(GL_ARRAY_BUFFER, _board_vertex_vbo);
+void BoardRenderer::RenderChunked(const GameBoard &board, const Camera &camera,
+                                  RenderQueue &queue) {
+  QRectF visible_rect =
+      camera.visible_rect().adjusted(-kCullMargin, -kCullMargin, kCullMargin,
+                                     kCullMargin);
 
-  _program_board.bind();
-  int pos_location = _program_board.attributeLocation("position");
-  glVertexAttribPointer(pos_location, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float),
-                        reinterpret_cast<void *>(0));
-  glEnableVertexAttribArray(pos_location);
+  for (auto &chunk : _chunks) {
+    QRectF chunk_rect(chunk.x, chunk.y, chunk.width, chunk.height);
+    if (!visible_rect.intersects(chunk_rect)) {
+      continue;
+    }
+    UploadChunkTiles(chunk, board);
+    // chunks outlive the frame, capturing only pointers keeps the callback
+    // small enough for std::function to store without allocating
+    const Chunk *drawn = &chunk;
+    queue.Submit({RenderQueue::kTiles,
+                  &_resources->program_board(),
+                  {{_resources->pieces_texture(), 0}},
+                  chunk.vao,
+                  _view,
+                  6,
+                  chunk.width * chunk.height,
+                  [this, drawn]() {
+                    glUniform3i(_resources->chunk_location(), drawn->x,
+                                drawn->y, drawn->height);
+                  },
+                  {}});
+  }
+}
+
+void BoardRenderer::RenderTypeMap(RenderQueue &queue) {
+  // stationary tiles, one quad spanning the board
+  queue.Submit({RenderQueue::kTiles,
+                &_resources->program_type_map(),
+                {{_resources->pieces_texture(), _type_map_texture}},
+                _type_map_vao,
+                _view,
+                6,
+                0,
+                {},
+                {}});
+}
 
-  // texture and offset buffer
-  glBindBuffer(GL_ARRAY_BUFFER, _board_params_vbo);
+void BoardRenderer::RenderMovingTiles(RenderQueue &queue) {
+  // moving tiles, one instance per tile
+  if (_moving_instances.empty()) {
+    return;
+  }
 
-  size_t buffer_element_size = (5 * sizeof(float)) + sizeof(int);
-  void *tex_offset = reinterpret_cast<void *>(0);
-  void *offset_offset = reinterpret_cast<void *>((sizeof(float) * 2));
-  void *is_gold_offset = reinterpret_cast<void *>((sizeof(float) * 5));
+  GLsizeiptr size = sizeof(float) * _moving_instances.size();
+  glBindBuffer(GL_ARRAY_BUFFER, _moving_instance_vbo);
+  glBufferData(GL_ARRAY_BUFFER, size, _moving_instances.data(),
+               GL_STREAM_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  _uploaded_bytes += size;
+
+  queue.Submit({RenderQueue::kMovingTiles,
+                &_resources->program_moving(),
+                {{_resources->pieces_texture(), 0}},
+                _moving_vao,
+                _view,
+                6,
+                static_cast<GLsizei>(_moving_instances.size() / 3),
+                {},
+                {}});
+}
 
-  int tex_location = _program_board.attributeLocation("tex");
-  glVertexAttribPointer(tex_location, 2, GL_FLOAT, GL_FALSE,
-                        buffer_element_size, tex_offset);
-  glEnableVertexAttribArray(tex_location);
+void BoardRenderer::GenerateChunks(int new_width, int new_height) {
+  DeleteChunks();
+
+  QOpenGLShaderProgram &program = _resources->program_board();
+  int position_location = program.attributeLocation("position");
+  int offset_location = program.attributeLocation("tile_offset");
+  int state_location = program.attributeLocation("tile_state");
+  GLsizei tile_size = sizeof(GameBoard::BoardTile);
+  for (int x = 0; x < new_width; x += kChunkSize) {
+    for (int y = 0; y < new_height; y += kChunkSize) {
+      Chunk chunk;
+      chunk.x = x;
+      chunk.y = y;
+      chunk.width = std::min(kChunkSize, new_width - x);
+      chunk.height = std::min(kChunkSize, new_height - y);
+      chunk.uploaded_stamp = 0;
+
+      glGenVertexArrays(1, &chunk.vao);
+      glGenBuffers(1, &chunk.tiles_vbo);
+
+      glBindVertexArray(chunk.vao);
+      // unit tile quad
+      glBindBuffer(GL_ARRAY_BUFFER, _resources->quad_vbo());
+      glVertexAttribPointer(position_location, 2, GL_FLOAT, GL_FALSE,
+                            2 * sizeof(float), reinterpret_cast<void *>(0));
+      glEnableVertexAttribArray(position_location);
+
+      // packed board tiles, one per instance
+      glBindBuffer(GL_ARRAY_BUFFER, chunk.tiles_vbo);
+      glVertexAttribIPointer(
+          offset_location, 2, GL_SHORT, tile_size,
+          reinterpret_cast<void *>(offsetof(GameBoard::BoardTile,
+                                            fixed_offset_x)));
+      glEnableVertexAttribArray(offset_location);
+      glVertexAttribDivisor(offset_location, 1);
+      glVertexAttribIPointer(
+          state_location, 1, GL_UNSIGNED_BYTE, tile_size,
+          reinterpret_cast<void *>(offsetof(GameBoard::BoardTile, state)));
+      glEnableVertexAttribArray(state_location);
+      glVertexAttribDivisor(state_location, 1);
+
+      glBindBuffer(GL_ARRAY_BUFFER, 0);
+      glBindVertexArray(0);
+
+      _chunks.push_back(chunk);
+    }
+  }
+}
 
-  int offset_location = _program_board.attributeLocation("offset");
-  glVertexAttribPointer(offset_location, 3, GL_FLOAT, GL_FALSE,
-                        buffer_element_size, offset_offset);
-  glEnableVertexAttribArray(offset_location);
+void BoardRenderer::DeleteChunks() {
+  for (auto &chunk : _chunks) {
+    glDeleteVertexArrays(1, &chunk.vao);
+    glDeleteBuffers(1, &chunk.tiles_vbo);
+  }
+  _chunks.clear();
+}
 
-  // int is_gold_location = _program_board.attributeLocation("is_gold");
-  // glVertexAttribPointer(is_gold_location, 1, GL_FLOAT, GL_FALSE,
-  //                       buffer_element_size, is_gold_offset);
-  // glEnableVertexAttribArray(is_gold_location);
+void BoardRenderer::UploadChunkTiles(Chunk &chunk, const GameBoard &board) {
+  // settled chunks keep their buffer, so uploads scale with the changes
+  uint64_t stamp =
+      board.change_stamp(chunk.x / kChunkSize, chunk.y / kChunkSize);
+  if (chunk.uploaded_stamp == stamp) {
+    return;
+  }
+  chunk.uploaded_stamp = stamp;
+
+  // the tiles are uploaded as stored, the shader unpacks them
+  _chunk_tiles.resize(chunk.width * chunk.height);
+  auto chunk_column = _chunk_tiles.begin();
+  for (int x = chunk.x; x < chunk.x + chunk.width; x++) {
+    const GameBoard::BoardTile *column = board.column(x);
+    chunk_column = std::copy_n(column + chunk.y, chunk.height, chunk_column);
+  }
 
+  GLsizeiptr size = sizeof(GameBoard::BoardTile) * _chunk_tiles.size();
+  glBindBuffer(GL_ARRAY_BUFFER, chunk.tiles_vbo);
+  glBufferData(GL_ARRAY_BUFFER, size, _chunk_tiles.data(), GL_STREAM_DRAW);
   glBindBuffer(GL_ARRAY_BUFFER, 0);
+  _uploaded_bytes += size;
+}
 
-  int tex_uniform = _program_board.uniformLocation("u_tex_background");
-  glUniform1i(tex_uniform, 0);
-  _program_board.release();
+void BoardRenderer::GenerateTypeMapBuffers() {
+  glGenTextures(1, &_type_map_texture);
+  glGenVertexArrays(1, &_type_map_vao);
+  glGenBuffers(1, &_type_map_vbo);
+  glGenVertexArrays(1, &_moving_vao);
+  glGenBuffers(1, &_moving_instance_vbo);
+
+  // board quad, filled when the board size is known
+  glBindVertexArray(_type_map_vao);
+  glBindBuffer(GL_ARRAY_BUFFER, _type_map_vbo);
+  int pos_location =
+      _resources->program_type_map().attributeLocation("position");
+  glVertexAttribPointer(pos_location, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float),
+                        reinterpret_cast<void *>(0));
+  glEnableVertexAttribArray(pos_location);
+
+  // unit tile quad, see BoardResources
+  glBindVertexArray(_moving_vao);
+  glBindBuffer(GL_ARRAY_BUFFER, _resources->quad_vbo());
+  QOpenGLShaderProgram &program_moving = _resources->program_moving();
+  pos_location = program_moving.attributeLocation("position");
+  glVertexAttribPointer(pos_location, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float),
+                        reinterpret_cast<void *>(0));
+  glEnableVertexAttribArray(pos_location);
+
+  // per instance board position including offset, and atlas cell
+  glBindBuffer(GL_ARRAY_BUFFER, _moving_instance_vbo);
+  int instance_location = program_moving.attributeLocation("instance");
+  glVertexAttribPointer(instance_location, 3, GL_FLOAT, GL_FALSE,
+                        3 * sizeof(float), reinterpret_cast<void *>(0));
+  glEnableVertexAttribArray(instance_location);
+  glVertexAttribDivisor(instance_location, 1);
+
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
   glBindVertexArray(0);
 }
 
-void BoardRenderer::CompileShaders() {
-  QFile vs_file(":/GL_shaders/gamepiece_vs.glsl");
-  QFile fs_file(":/GL_shaders/gamepiece_fs.glsl");
-  vs_file.open(QIODevice::ReadOnly);
-  fs_file.open(QIODevice::ReadOnly);
-  QByteArray vs_source = vs_file.readAll();
-  QByteArray fs_source = fs_file.readAll();
-
-  if (QOpenGLContext::currentContext()->isOpenGLES()) {
-    vs_source.prepend(QByteArrayLiteral("#version 300 es\n"));
-    fs_source.prepend(QByteArrayLiteral("#version 300 es\n"));
-  } else {
-    vs_source.prepend(QByteArrayLiteral("#version 410\n"));
-    fs_source.prepend(QByteArrayLiteral("#version 410\n"));
-  }
-
-  _program_board.addShaderFromSourceCode(QOpenGLShader::Vertex, vs_source);
-  _program_board.addShaderFromSourceCode(QOpenGLShader::Fragment, fs_source);
-  _program_board.link();
-}
-
-void BoardRenderer::RebuildBoardVertexBuffer(int new_width, int new_height) {
-  int max_size = std::max(new_width, new_height);
-  float piece_size = 2.0f / max_size;
-  float x_centering_offset = ((piece_size * new_width) / 2);
-  float y_centering_offset = ((piece_size * new_height) / 2);
-
-  // Create a buffer of the vertices for each tile.
-  // To draw tile ABCD, we draw two triangles ACB and ADC
-  //   A*******B
-  //   * *     *
-  // ^ *   *   *
-  // | *     * *
-  // y D*******C
-  //   x ->
-
-  _vertex_count = 0;
-  std::vector<float> vertices;
-  for (int x = 0; x < new_width; x++) {
-    for (int y = 0; y < new_height; y++) {
-      _vertex_count += 6;
-      float Dx = (piece_size * x) - x_centering_offset;
-      float Dy = (piece_size * y) - y_centering_offset;
-      float Cx = Dx + piece_size;
-      float Cy = Dy;
-      float Bx = Cx;
-      float By = Cy + piece_size;
-      float Ax = Dx;
-      float Ay = By;
-
-      std::vector<float> triangle_ACB = {Ax, Ay, Cx, Cy, Bx, By};
-      std::vector<float> triangle_ADC = {Ax, Ay, Dx, Dy, Cx, Cy};
-      vertices.insert(vertices.end(), triangle_ACB.begin(), triangle_ACB.end());
-      vertices.insert(vertices.end(), triangle_ADC.begin(), triangle_ADC.end());
-    }
+void BoardRenderer::GenerateTypeMap(int new_width, int new_height) {
+  if (new_width > _resources->max_texture_size() ||
+      new_height > _resources->max_texture_size()) {
+    _type_map_shadow.clear();
+    _type_map_stamps.clear();
+    return;
   }
 
-  glBindBuffer(GL_ARRAY_BUFFER, _board_vertex_vbo);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(float) * vertices.size(),
-               vertices.data(), GL_STATIC_DRAW);
+  // one texture row per board column, so that board columns upload as rows
+  _type_map_shadow.assign(new_width * new_height, kTypeMapEmpty);
+  _type_map_stamps.assign(((new_width + kChunkSize - 1) / kChunkSize) *
+                              ((new_height + kChunkSize - 1) / kChunkSize),
+                          0);
+  glBindTexture(GL_TEXTURE_2D, _type_map_texture);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_R8UI, new_height, new_width, 0,
+               GL_RED_INTEGER, GL_UNSIGNED_BYTE, _type_map_shadow.data());
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  _uploaded_bytes += _type_map_shadow.size();
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  GLfloat w = new_width;
+  GLfloat h = new_height;
+  GLfloat board_quad[6 * 2] = {
+      0.0f, h,     // A
+      w,    0.0f,  // C
+      w,    h,     // B
+      0.0f, h,     // A
+      0.0f, 0.0f,  // D
+      w,    0.0f   // C
+  };
+  glBindBuffer(GL_ARRAY_BUFFER, _type_map_vbo);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(board_quad), board_quad,
+               GL_STATIC_DRAW);
   glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
-void BoardRenderer::RebuildBoardParamsBuffer(const GameBoard &board) {
-  int max_size = std::max(board.width(), board.height());
-
-  std::vector<float> pieces_interleaved;
-  for (auto column : board.board()) {
-    for (auto piece : column) {
-      // each piece consists of 6 vertices
-      float offset_x = Remap(-max_size, max_size, -2.0f, 2.0f, piece.offset_x);
-      float offset_y = Remap(-max_size, max_size, -2.0f, 2.0f, piece.offset_y);
-      float offset_z = 0;
-      float is_gold = 0.0f;
-      TextureCoords tex_coords = _piece_texture_coords[piece.type];
-      float Dx = tex_coords.begin;
-      float Dy = 1.0f;
-      float Cx = tex_coords.end;
-      float Cy = 1.0f;
-      float Bx = tex_coords.end;
-      float By = 0.0f;
-      float Ax = tex_coords.begin;
-      float Ay = 0.0f;
-
-      std::vector<float> a = {Ax, Ay, offset_x, offset_y, offset_z, is_gold};
-      std::vector<float> b = {Bx, By, offset_x, offset_y, offset_z, is_gold};
-      std::vector<float> c = {Cx, Cy, offset_x, offset_y, offset_z, is_gold};
-      std::vector<float> d = {Dx, Dy, offset_x, offset_y, offset_z, is_gold};
-
-      // ACB ADC
-      pieces_interleaved.insert(pieces_interleaved.end(), a.begin(), a.end());
-      pieces_interleaved.insert(pieces_interleaved.end(), c.begin(), c.end());
-      pieces_interleaved.insert(pieces_interleaved.end(), b.begin(), b.end());
-      pieces_interleaved.insert(pieces_interleaved.end(), a.begin(), a.end());
-      pieces_interleaved.insert(pieces_interleaved.end(), d.begin(), d.end());
-      pieces_interleaved.insert(pieces_interleaved.end(), c.begin(), c.end());
+bool BoardRenderer::UpdateTypeMap(const GameBoard &board) {
+  // Tiles with an offset are drawn as instances and left empty in the type
+  // map. Only the chunks that changed since the last update are compared with
+  // the type map, and only the rectangle spanning the changed entries is
+  // uploaded.
+  _moving_instances.clear();
+  board.ForEachAnimated([this, &board](Coordinates pos) {
+    const auto &piece = board.tile(pos.x, pos.y);
+    if (piece.moving()) {
+      _moving_instances.push_back(pos.x + piece.offset_x());
+      _moving_instances.push_back(pos.y + piece.offset_y());
+      _moving_instances.push_back(_resources->atlas_cell(piece.type()));
+    }
+  });
+
+  int width = board.width();
+  int height = board.height();
+  int min_x = width;
+  int max_x = -1;
+  int min_y = height;
+  int max_y = -1;
+  int chunk_rows = (height + kChunkSize - 1) / kChunkSize;
+  for (int chunk_x = 0; chunk_x * kChunkSize < width; chunk_x++) {
+    for (int chunk_y = 0; chunk_y < chunk_rows; chunk_y++) {
+      uint64_t &stamp = _type_map_stamps[chunk_x * chunk_rows + chunk_y];
+      if (stamp == board.change_stamp(chunk_x, chunk_y)) {
+        continue;
+      }
+      stamp = board.change_stamp(chunk_x, chunk_y);
+
+      int end_x = std::min(width, (chunk_x + 1) * kChunkSize);
+      int end_y = std::min(height, (chunk_y + 1) * kChunkSize);
+      for (int x = chunk_x * kChunkSize; x < end_x; x++) {
+        const GameBoard::BoardTile *column = board.column(x);
+        for (int y = chunk_y * kChunkSize; y < end_y; y++) {
+          const auto &piece = column[y];
+          uint8_t value = piece.moving() ? kTypeMapEmpty
+                                         : _resources->atlas_cell(piece.type());
+          uint8_t &shadow = _type_map_shadow[x * height + y];
+          if (shadow != value) {
+            shadow = value;
+            min_x = std::min(min_x, x);
+            max_x = std::max(max_x, x);
+            min_y = std::min(min_y, y);
+            max_y = std::max(max_y, y);
+          }
+        }
+      }
     }
   }
 
-  glBindBuffer(GL_ARRAY_BUFFER, _board_params_vbo);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(float) * pieces_interleaved.size(),
-               pieces_interleaved.data(), GL_STREAM_DRAW);
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  if (max_x < 0) {
+    return false;
+  }
+
+  glBindTexture(GL_TEXTURE_2D, _type_map_texture);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, height);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, min_y, min_x, max_y - min_y + 1,
+                  max_x - min_x + 1, GL_RED_INTEGER, GL_UNSIGNED_BYTE,
+                  &_type_map_shadow[min_x * height + min_y]);
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  _uploaded_bytes += (max_x - min_x + 1) * (max_y - min_y + 1);
+  return true;
 }
@@ -3,47 +3,114 @@
 
 #include <QMatrix4x4>
 #include <QOpenGLExtraFunctions>
-#include <QOpenGLShaderProgram>
-#include <QOpenGLTexture>
-#include <map>
+#include <QRectF>
+#include <cstdint>
+#include <vector>
 
+#include "board_resources.hpp"
+#include "camera.hpp"
+#include "particle_system.hpp"
+#include "render_queue.hpp"
 #include "game_logic/game_board.hpp"
 
+// Draws one board. Textures and programs come from BoardResources, so the
+// draws of several renderers batch in one RenderQueue, each in its own view.
 class BoardRenderer : public QObject, protected QOpenGLExtraFunctions {
   Q_OBJECT
 
  public:
+  // A rectangular part of the board with its own buffers, chunks outside of
+  // the camera view are neither updated nor drawn. Chunks whose tiles did not
+  // change since their last upload are drawn from the buffer as is.
   typedef struct {
-    float begin;
-    float end;
-  } TextureCoords;
+    int x;
+    int y;
+    int width;
+    int height;
+    GLuint vao;
+    GLuint tiles_vbo;
+    // board change stamp of the chunk when it was uploaded
+    uint64_t uploaded_stamp;
+  } Chunk;
+
+  // kChunked draws every visible tile as an instance, reading the packed board
+  // tiles as integer attributes. kTypeMap draws the
+  // stationary tiles from a one byte per tile texture with a single quad and
+  // only expands the moving ones. kAuto picks kTypeMap for huge boards or when
+  // zoomed out far.
+  enum RenderPath { kChunked = 0, kTypeMap, kAuto };
 
   BoardRenderer();
   ~BoardRenderer();
 
-  void Init();
-  void Render(const GameBoard& board);
-  void SetProjection(const QMatrix4x4& projection_matrix);
+  // view is the RenderQueue view slot of this board
+  void Init(BoardResources& resources, int view);
+  void Render(const GameBoard& board, const Camera& camera, RenderQueue& queue);
+  // clip is the part of the target the board is drawn in, see
+  // RenderQueue::SetView
+  void SetProjection(const QMatrix4x4& projection_matrix,
+                     const QRectF& clip = QRectF());
+  void SetRenderPath(RenderPath render_path);
+
+  // Render split in parts, so the stationary tiles can be cached in a layer.
+  // Update must be called once per frame before drawing either part,
+  // static_version changes whenever the static part would draw differently.
+  void Update(const GameBoard& board, const Camera& camera);
+  void RenderStatic(RenderQueue& queue);
+  void RenderDynamic(const GameBoard& board, const Camera& camera,
+                     RenderQueue& queue);
+  quint64 static_version() const { return _static_version; }
+  // bytes of board data uploaded since Init, for profiling
+  quint64 uploaded_bytes() const { return _uploaded_bytes; }
 
  private:
-  float Remap(float min_old, float max_old, float min_new, float max_new,
-              float value);
-  void LoadTextures();
-  void GenerateBuffers();
-  void CompileShaders();
-  void RebuildBoardParamsBuffer(const GameBoard& board);
-  void RebuildBoardVertexBuffer(int new_width, int new_height);
+  bool UseTypeMap(const GameBoard& board, const Camera& camera) const;
+  void EmitDeletions(const GameBoard& board);
+  void RenderChunked(const GameBoard& board, const Camera& camera,
+                     RenderQueue& queue);
+  void RenderTypeMap(RenderQueue& queue);
+  void RenderMovingTiles(RenderQueue& queue);
+  void GenerateChunks(int new_width, int new_height);
+  void DeleteChunks();
+  void UploadChunkTiles(Chunk& chunk, const GameBoard& board);
+  void GenerateTypeMapBuffers();
+  void GenerateTypeMap(int new_width, int new_height);
+  bool UpdateTypeMap(const GameBoard& board);
+
+  // chunks are the board's change chunks, see GameBoard::change_stamp
+  static constexpr int kChunkSize = GameBoard::kChangeChunkSize;
+  // tiles can be drawn this far from their position while animating
+  static constexpr float kCullMargin = 2.0f;
+  static constexpr int kTypeMapTileThreshold = 128 * 128;
+  static constexpr uint8_t kTypeMapEmpty = 0xFF;
 
   int _width;
   int _height;
+  RenderPath _render_path;
+  bool _use_type_map;
+  quint64 _static_version;
+  quint64 _uploaded_bytes;
+  // uniform block slot of the board transform, see RenderQueue
+  int _view;
+  BoardResources* _resources;
   QMatrix4x4 _projection_matrix;
-  GLuint _board_vao;
-  GLuint _board_vertex_vbo;
-  GLuint _board_params_vbo;
-  GLuint _vertex_count;
-  std::map<GameBoard::PieceType, TextureCoords> _piece_texture_coords;
-  QOpenGLTexture* _pieces_texture;
-  QOpenGLShaderProgram _program_board;
+  QMatrix4x4 _transform;
+  QRectF _clip;
+  std::vector<Chunk> _chunks;
+  GLuint _type_map_texture;
+  GLuint _type_map_vao;
+  GLuint _type_map_vbo;
+  GLuint _moving_vao;
+  GLuint _moving_instance_vbo;
+  // type map contents as uploaded, column major like the board
+  std::vector<uint8_t> _type_map_shadow;
+  // board change stamp per chunk at the last type map update
+  std::vector<uint64_t> _type_map_stamps;
+  std::vector<float> _moving_instances;
+  // tiles of the chunk being uploaded, contiguous unlike the board columns
+  std::vector<GameBoard::BoardTile> _chunk_tiles;
+  ParticleSystem _particles;
+  uint64_t _deletion_version;
 };
 
 #endif  // SOURCE_GRAPHICS_ENGINE_BOARD_RENDERER_HPP_
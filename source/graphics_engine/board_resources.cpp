@@ -0,0 +1,106 @@
+#include "board_resources.hpp"
+
+#include <algorithm>
+
+#include "particle_system.hpp"
+
+BoardResources::BoardResources()
+    : _max_texture_size(0),
+      _pieces_texture(nullptr),
+      _quad_vbo(0),
+      _chunk_location(0) {
+  Q_INIT_RESOURCE(GL_shaders);
+}
+
+BoardResources::~BoardResources() {}
+
+QStringList BoardResources::ImagePaths() { return {":/images/pieces.png"}; }
+
+QStringList BoardResources::ShaderPaths() {
+  QStringList paths = {
+      ":/GL_shaders/gamepiece_vs.glsl", ":/GL_shaders/gamepiece_fs.glsl",
+      ":/GL_shaders/typemap_vs.glsl", ":/GL_shaders/typemap_fs.glsl",
+      ":/GL_shaders/moving_tiles_vs.glsl"};
+  return paths + ParticleSystem::ShaderPaths();
+}
+
+void BoardResources::Init(AssetLoader &assets, RenderQueue &queue) {
+  initializeOpenGLFunctions();
+
+  glGetIntegerv(GL_MAX_TEXTURE_SIZE, &_max_texture_size);
+  LoadTextures(assets);
+  CompileShaders(assets, queue);
+  GenerateQuad();
+}
+
+void BoardResources::LoadTextures(AssetLoader &assets) {
+  _pieces_texture = assets.CreateTexture(":/images/pieces.png");
+
+  // the atlas holds the pieces side by side
+  _piece_atlas_cells[GameBoard::kChameleon] = 0;
+  _piece_atlas_cells[GameBoard::kTux] = 1;
+  _piece_atlas_cells[GameBoard::kHat] = 2;
+  _piece_atlas_cells[GameBoard::kWildebeest] = 3;
+}
+
+void BoardResources::CompileShaders(AssetLoader &assets, RenderQueue &queue) {
+  assets.BuildProgram(_program_board, ":/GL_shaders/gamepiece_vs.glsl",
+                      ":/GL_shaders/gamepiece_fs.glsl");
+  assets.BuildProgram(_program_type_map, ":/GL_shaders/typemap_vs.glsl",
+                      ":/GL_shaders/typemap_fs.glsl");
+  assets.BuildProgram(_program_moving, ":/GL_shaders/moving_tiles_vs.glsl",
+                      ":/GL_shaders/gamepiece_fs.glsl");
+  ParticleSystem::BuildProgram(_program_particles, assets);
+
+  queue.AttachProgram(_program_board);
+  queue.AttachProgram(_program_type_map);
+  queue.AttachProgram(_program_moving);
+  queue.AttachProgram(_program_particles);
+
+  _program_board.bind();
+  int tex_uniform = _program_board.uniformLocation("u_tex_background");
+  glUniform1i(tex_uniform, 0);
+  std::array<GLint, kAtlasCells> atlas_cells;
+  std::copy(_piece_atlas_cells.begin(), _piece_atlas_cells.end(),
+            atlas_cells.begin());
+  _program_board.setUniformValueArray("u_atlas_cells", atlas_cells.data(),
+                                      kAtlasCells);
+  _program_board.setUniformValue("u_offset_scale",
+                                 1.0f / GameBoard::BoardTile::kOffsetScale);
+  _chunk_location = _program_board.uniformLocation("u_chunk");
+  _program_board.release();
+
+  _program_moving.bind();
+  tex_uniform = _program_moving.uniformLocation("u_tex_background");
+  glUniform1i(tex_uniform, 0);
+  _program_moving.release();
+
+  _program_type_map.bind();
+  tex_uniform = _program_type_map.uniformLocation("u_tex_pieces");
+  glUniform1i(tex_uniform, 0);
+  int type_map_uniform = _program_type_map.uniformLocation("u_type_map");
+  glUniform1i(type_map_uniform, 1);
+  _program_type_map.release();
+}
+
+void BoardResources::GenerateQuad() {
+  // unit tile quad ACB ADC, shared by all tile instances
+  //   A*******B
+  //   * *     *
+  // ^ *   *   *
+  // | *     * *
+  // y D*******C
+  //   x ->
+  GLfloat unit_quad[6 * 2] = {
+      0.0f, 1.0f,  // A
+      1.0f, 0.0f,  // C
+      1.0f, 1.0f,  // B
+      0.0f, 1.0f,  // A
+      0.0f, 0.0f,  // D
+      1.0f, 0.0f   // C
+  };
+  glGenBuffers(1, &_quad_vbo);
+  glBindBuffer(GL_ARRAY_BUFFER, _quad_vbo);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(unit_quad), unit_quad, GL_STATIC_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
@@ -0,0 +1,59 @@
+#ifndef SOURCE_GRAPHICS_ENGINE_BOARD_RESOURCES_HPP_
+#define SOURCE_GRAPHICS_ENGINE_BOARD_RESOURCES_HPP_
+
+#include <QOpenGLExtraFunctions>
+#include <QOpenGLShaderProgram>
+#include <QOpenGLTexture>
+#include <QStringList>
+#include <array>
+#include <cstdint>
+
+#include "asset_loader.hpp"
+#include "render_queue.hpp"
+#include "game_logic/game_board.hpp"
+
+// GL resources shared by every BoardRenderer: the piece atlas, the programs
+// and the unit tile quad. Sharing them lets the RenderQueue batch the draws
+// of all boards, which then only differ in their view.
+class BoardResources : protected QOpenGLExtraFunctions {
+ public:
+  static constexpr int kAtlasCells = 4;
+
+  BoardResources();
+  ~BoardResources();
+
+  // assets Init takes from the loader, request them before calling it
+  static QStringList ImagePaths();
+  static QStringList ShaderPaths();
+  void Init(AssetLoader &assets, RenderQueue &queue);
+
+  GLuint pieces_texture() const { return _pieces_texture->textureId(); }
+  uint8_t atlas_cell(GameBoard::PieceType type) const {
+    return _piece_atlas_cells[type];
+  }
+  GLint max_texture_size() const { return _max_texture_size; }
+  // unit tile quad ACB ADC
+  GLuint quad_vbo() const { return _quad_vbo; }
+  QOpenGLShaderProgram &program_board() { return _program_board; }
+  QOpenGLShaderProgram &program_type_map() { return _program_type_map; }
+  QOpenGLShaderProgram &program_moving() { return _program_moving; }
+  QOpenGLShaderProgram &program_particles() { return _program_particles; }
+  int chunk_location() const { return _chunk_location; }
+
+ private:
+  void LoadTextures(AssetLoader &assets);
+  void CompileShaders(AssetLoader &assets, RenderQueue &queue);
+  void GenerateQuad();
+
+  GLint _max_texture_size;
+  std::array<uint8_t, kAtlasCells> _piece_atlas_cells;
+  QOpenGLTexture *_pieces_texture;
+  GLuint _quad_vbo;
+  QOpenGLShaderProgram _program_board;
+  QOpenGLShaderProgram _program_type_map;
+  QOpenGLShaderProgram _program_moving;
+  QOpenGLShaderProgram _program_particles;
+  int _chunk_location;
+};
+
+#endif  // SOURCE_GRAPHICS_ENGINE_BOARD_RESOURCES_HPP_
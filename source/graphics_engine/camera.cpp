@@ -0,0 +1,77 @@
+#include "camera.hpp"
+
+#include <algorithm>
+
+Camera::Camera()
+    : _view_width(1),
+      _view_height(1),
+      _board_width(1),
+      _board_height(1),
+      _center(0.5f, 0.5f),
+      _span(1.0f) {}
+
+void Camera::SetViewport(int width, int height) {
+  _view_width = std::max(width, 1);
+  _view_height = std::max(height, 1);
+}
+
+void Camera::FitBoard(int board_width, int board_height) {
+  _board_width = board_width;
+  _board_height = board_height;
+  _center = QPointF(board_width / 2.0f, board_height / 2.0f);
+  _span = std::max(board_width, board_height);
+}
+
+void Camera::Pan(QPointF window_delta) {
+  // window y points down, board y points up
+  float units_per_pixel = UnitsPerPixel();
+  _center.rx() -= window_delta.x() * units_per_pixel;
+  _center.ry() += window_delta.y() * units_per_pixel;
+  Clamp();
+}
+
+void Camera::Zoom(float factor, QPointF window_anchor) {
+  // keep the board position under the anchor in place
+  QPointF anchor = WindowToBoard(window_anchor);
+  float max_span = std::max(_board_width, _board_height) * kMaxSpanFactor;
+  _span = std::clamp(_span * factor, kMinSpan, std::max(kMinSpan, max_span));
+
+  float units_per_pixel = UnitsPerPixel();
+  _center.setX(anchor.x() -
+               (window_anchor.x() - _view_width / 2.0f) * units_per_pixel);
+  _center.setY(anchor.y() +
+               (window_anchor.y() - _view_height / 2.0f) * units_per_pixel);
+  Clamp();
+}
+
+QPointF Camera::WindowToBoard(QPointF window_pos) const {
+  float units_per_pixel = UnitsPerPixel();
+  return QPointF(
+      _center.x() + (window_pos.x() - _view_width / 2.0f) * units_per_pixel,
+      _center.y() - (window_pos.y() - _view_height / 2.0f) * units_per_pixel);
+}
+
+QMatrix4x4 Camera::view_matrix() const {
+  // board space to the unit square used by the projection matrix
+  QMatrix4x4 view;
+  view.scale(2.0f / _span, 2.0f / _span);
+  view.translate(-_center.x(), -_center.y());
+  return view;
+}
+
+QRectF Camera::visible_rect() const {
+  float units_per_pixel = UnitsPerPixel();
+  float half_width = _view_width * units_per_pixel / 2.0f;
+  float half_height = _view_height * units_per_pixel / 2.0f;
+  return QRectF(_center.x() - half_width, _center.y() - half_height,
+                half_width * 2.0f, half_height * 2.0f);
+}
+
+float Camera::UnitsPerPixel() const {
+  return _span / std::min(_view_width, _view_height);
+}
+
+void Camera::Clamp() {
+  _center.setX(std::clamp<qreal>(_center.x(), 0.0f, _board_width));
+  _center.setY(std::clamp<qreal>(_center.y(), 0.0f, _board_height));
+}
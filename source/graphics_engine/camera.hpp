@@ -0,0 +1,39 @@
+#ifndef SOURCE_GRAPHICS_ENGINE_CAMERA_HPP_
+#define SOURCE_GRAPHICS_ENGINE_CAMERA_HPP_
+
+#include <QMatrix4x4>
+#include <QPointF>
+#include <QRectF>
+
+// Pan/zoom camera over the game board. Board space has its origin in the
+// bottom left corner of the board and one unit per tile, the camera maps the
+// span around its center onto the largest square that fits the viewport.
+class Camera {
+ public:
+  Camera();
+
+  void SetViewport(int width, int height);
+  void FitBoard(int board_width, int board_height);
+  void Pan(QPointF window_delta);
+  void Zoom(float factor, QPointF window_anchor);
+
+  QPointF WindowToBoard(QPointF window_pos) const;
+  QMatrix4x4 view_matrix() const;
+  QRectF visible_rect() const;
+
+ private:
+  float UnitsPerPixel() const;
+  void Clamp();
+
+  static constexpr float kMinSpan = 3.0f;
+  static constexpr float kMaxSpanFactor = 1.5f;
+
+  int _view_width;
+  int _view_height;
+  int _board_width;
+  int _board_height;
+  QPointF _center;
+  float _span;
+};
+
+#endif  // SOURCE_GRAPHICS_ENGINE_CAMERA_HPP_
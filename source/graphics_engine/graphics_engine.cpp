@@ -1,32 +1,60 @@
 // GraphicsEngine.cpp
 #include "graphics_engine.hpp"
 
+#include <QKeyEvent>
+#include <QKeySequence>
 #include <QMouseEvent>
 #include <QMutexLocker>
 #include <QOpenGLExtraFunctions>
 #include <QOpenGLTexture>
 #include <QTemporaryFile>
+#include <QTouchEvent>
 #include <QVector2D>
 #include <QVector3D>
+#include <QWheelEvent>
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 
 #ifdef ANDROID
 #include <GLES3/gl3.h>
 #endif
 
-GraphicsEngine::GraphicsEngine()
+GraphicsEngine::GraphicsEngine(int board_count)
     : QOpenGLWindow(),
-      _game_logic(),
-      _game_width(1),
-      _game_height(1),
+      _drag_board(kNoBoard),
+      _pan_board(kNoBoard),
+      _focus_board(0),
+      _quality(1000.0f / kFPS),
+      _assets_loaded(false),
+      _startup_reported(false),
+      _first_frame_drawn(false),
+      _frame_allocations(0),
+      _allocation_frames(0),
       _frame_timer(),
       _tick(0),
       _is_initialized(false),
       _view_width(1),
       _view_height(1),
-      _opengl_mutex(QMutex::Recursive) {
+      _opengl_mutex(QMutex::Recursive),
+      _title_model_location(0) {
   Q_INIT_RESOURCE(GL_shaders);
+  _startup_clock.start();
+  // decode and read everything while the window and context are created
+  QStringList images = {kBackgroundImage, kTitleImage};
+  QStringList shaders = {
+      ":/GL_shaders/background_vs.glsl", ":/GL_shaders/background_fs.glsl",
+      ":/GL_shaders/title_vs.glsl", ":/GL_shaders/title_fs.glsl"};
+  _assets.Start(images + BoardResources::ImagePaths(),
+                shaders + BoardResources::ShaderPaths());
+  board_count = std::clamp(board_count, 1, RenderQueue::kMaxViews);
+  for (int i = 0; i < board_count; i++) {
+    _boards.push_back(std::make_unique<Board>());
+    FitCameraToBoard(*_boards.back());
+  }
+  _touch_releases.resize(board_count);
+  _input_clock.start();
 
   _frame_timer.setInterval(1000.0f / kFPS);
   connect(&_frame_timer, SIGNAL(timeout()), this, SLOT(ExecuteFrame()));
@@ -39,67 +67,252 @@ QSize GraphicsEngine::minimumSizeHint() const { return QSize(600, 600); }
 
 QSize GraphicsEngine::sizeHint() const { return QSize(600, 600); }
 
+void GraphicsEngine::SetInputPrediction(float milliseconds) {
+  _input_queue.SetPredictionHorizon(milliseconds);
+}
+
+void GraphicsEngine::SetSeed(uint64_t seed) {
+  for (auto &board : _boards) {
+    board->logic.Seed(seed);
+  }
+}
+
+void GraphicsEngine::SetQuality(int level) { _quality.SetOverride(level); }
+
+bool GraphicsEngine::PublishState(const QString &name) {
+  for (int i = 0; i < static_cast<int>(_boards.size()); i++) {
+    QString board_name = i == 0 ? name : name + "_" + QString::number(i);
+    if (!_boards[i]->logic.PublishState(board_name.toStdString())) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool GraphicsEngine::LoadLevelPack(const QString &path) {
+  // the boards share one mapping
+  auto pack = std::make_shared<LevelPack>();
+  if (!pack->Open(path.toStdString())) {
+    return false;
+  }
+  for (auto &board : _boards) {
+    if (!board->logic.UseLevelPack(pack)) {
+      std::cerr << path.toStdString() << " holds no playable level"
+                << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
 void GraphicsEngine::ExecuteFrame() {
-  _game_logic.PhysicsTick();
+  uint64_t allocations = AllocationCounter::Count();
+  for (auto &board : _boards) {
+    board->logic.PhysicsTick();
+    if (board->logic.width() != board->game_width ||
+        board->logic.height() != board->game_height) {
+      FitCameraToBoard(*board);
+    }
+  }
+  _frame_allocations += AllocationCounter::Count() - allocations;
   ++_tick;
   update();
 }
 
 void GraphicsEngine::mousePressEvent(QMouseEvent *event) {
+  int index = BoardAt(event->pos());
+  if (index == kNoBoard) {
+    return;
+  }
   if (event->button() == Qt::LeftButton) {
-    QPointF mouse_coords = CoordsWindowToGame(event->pos());
-    _game_logic.MouseClick(mouse_coords.x(), mouse_coords.y());
+    _input_queue.Reset();
+    _drag_board = index;
+    _focus_board = index;
+    Board &board = *_boards[index];
+    QPointF mouse_coords = CoordsWindowToGame(board, event->pos());
+    board.logic.MouseClick(mouse_coords.x(), mouse_coords.y());
+  } else if (event->button() == Qt::RightButton ||
+             event->button() == Qt::MiddleButton) {
+    _pan_board = index;
+    _pan_last_pos = event->pos();
   }
 }
 
 void GraphicsEngine::mouseMoveEvent(QMouseEvent *event) {
   if (event->buttons().testFlag(Qt::LeftButton)) {
-    QPointF mouse_coords = CoordsWindowToGame(event->pos());
-    _game_logic.MouseMove(mouse_coords.x(), mouse_coords.y());
+    // dragging is applied once per frame, see LatchInput
+    _input_queue.PushMove(event->localPos(), _input_clock.nsecsElapsed());
+  } else if ((event->buttons().testFlag(Qt::RightButton) ||
+              event->buttons().testFlag(Qt::MiddleButton)) &&
+             _pan_board != kNoBoard) {
+    _boards[_pan_board]->camera.Pan(event->pos() - _pan_last_pos);
+    _pan_last_pos = event->pos();
   }
 }
 
 void GraphicsEngine::mouseReleaseEvent(QMouseEvent *event) {
-  if (event->button() == Qt::LeftButton) {
-    QPointF mouse_coords = CoordsWindowToGame(event->pos());
-    _game_logic.MouseRelease(mouse_coords.x(), mouse_coords.y());
+  if (event->button() == Qt::LeftButton && _drag_board != kNoBoard) {
+    // the release position supersedes any move not yet latched
+    _input_queue.Reset();
+    Board &board = *_boards[_drag_board];
+    QPointF mouse_coords = CoordsWindowToGame(board, event->pos());
+    board.logic.MouseRelease(mouse_coords.x(), mouse_coords.y());
+    _drag_board = kNoBoard;
+  }
+}
+
+void GraphicsEngine::wheelEvent(QWheelEvent *event) {
+  int index = BoardAt(event->position().toPoint());
+  if (index == kNoBoard) {
+    return;
   }
+  // one wheel notch is 120 units, scrolling up zooms in
+  Board &board = *_boards[index];
+  float notches = event->angleDelta().y() / 120.0f;
+  board.camera.Zoom(std::pow(kZoomStep, -notches),
+                    event->position() - board.region.topLeft());
 }
 
-float GraphicsEngine::Remap(float min_old, float max_old, float min_new,
-                            float max_new, float value) {
-  return (min_new +
-          (value - min_old) * (max_new - min_new) / (max_old - min_old));
+void GraphicsEngine::touchEvent(QTouchEvent *event) {
+  // a cancelled touch sequence ends all drags where they are
+  bool cancel = event->type() == QEvent::TouchCancel;
+  for (const QTouchEvent::TouchPoint &point : event->touchPoints()) {
+    int id = point.id();
+    auto touch = _touch_points.find(id);
+    if (point.state() == Qt::TouchPointPressed && !cancel) {
+      int index = BoardAt(point.pos().toPoint());
+      if (index == kNoBoard) {
+        continue;
+      }
+      _touch_points[id] = {index, point.pos(), false};
+      _focus_board = index;
+      Board &board = *_boards[index];
+      QPointF touch_coords = CoordsWindowToGame(board, point.pos());
+      board.logic.PointerPress(id, touch_coords.x(), touch_coords.y());
+    } else if (touch == _touch_points.end()) {
+      continue;
+    } else if (point.state() == Qt::TouchPointReleased || cancel) {
+      int index = touch->second.board;
+      QPointF touch_coords = CoordsWindowToGame(*_boards[index], point.pos());
+      _touch_releases[index].push_back(
+          {id, {static_cast<float>(touch_coords.x()),
+                static_cast<float>(touch_coords.y())}});
+      _touch_points.erase(touch);
+    } else if (point.state() == Qt::TouchPointMoved) {
+      touch->second.pos = point.pos();
+      touch->second.moved = true;
+    }
+  }
+  event->accept();
 }
 
-QPointF GraphicsEngine::CoordsWindowToGame(QPoint mouse_pos) {
-  // convert to square window space
-  float mouse_x = mouse_pos.x();
-  float mouse_y = mouse_pos.y();
-  int min_view_size = std::min(_view_width, _view_height);
-  float x_square_centering_offset = ((_view_width - min_view_size) / 2);
-  float y_square_centering_offset = ((_view_height - min_view_size) / 2);
-  float square_mouse_x = mouse_x - x_square_centering_offset;
-  float square_mouse_y = mouse_y - y_square_centering_offset;
-
-  // convert from square window to game space, including inverted y axis
-  _game_width = _game_logic.width();
-  _game_height = _game_logic.height();
-
-  int max_size = std::max(_game_width, _game_height);
-  float game_mouse_x = Remap(0, min_view_size, 0, max_size, square_mouse_x);
-  float game_mouse_y =
-      max_size - Remap(0, min_view_size, 0, max_size, square_mouse_y);
-
-  float x_centering_offset = ((max_size - _game_width) / 2);
-  float y_centering_offset = ((max_size - _game_height) / 2);
-  game_mouse_x -= x_centering_offset;
-  game_mouse_y -= y_centering_offset;
-
-  return QPointF(game_mouse_x, game_mouse_y);
+void GraphicsEngine::keyPressEvent(QKeyEvent *event) {
+  GameLogic &logic = _boards[_focus_board]->logic;
+  if (event->matches(QKeySequence::Undo)) {
+    logic.Undo();
+  } else if (event->matches(QKeySequence::Redo)) {
+    logic.Redo();
+  } else {
+    QOpenGLWindow::keyPressEvent(event);
+  }
+}
+
+QMatrix4x4 GraphicsEngine::SquareProjection(int width, int height) {
+  // ensure squareness
+  float aspect_ratio = (float)width / (float)height;
+  QMatrix4x4 projection;
+  if (aspect_ratio > 1.0f) {
+    // wide viewport, use full height
+    projection.ortho(-aspect_ratio, aspect_ratio, -1.0f, 1.0f, 0.0f, 10.0f);
+  } else {
+    // tall viewport, use full width
+    projection.ortho(-1.0f, 1.0f, -1.0f / aspect_ratio, 1.0f / aspect_ratio,
+                     0.0f, 10.0f);
+  }
+  return projection;
+}
+
+int GraphicsEngine::BoardAt(QPoint window_pos) const {
+  for (int i = 0; i < static_cast<int>(_boards.size()); i++) {
+    if (_boards[i]->region.contains(window_pos)) {
+      return i;
+    }
+  }
+  return kNoBoard;
+}
+
+QPointF GraphicsEngine::CoordsWindowToGame(const Board &board,
+                                           QPointF mouse_pos) {
+  // the camera maps region space to game space, including inverted y axis
+  return board.camera.WindowToBoard(mouse_pos - board.region.topLeft());
+}
+
+void GraphicsEngine::LatchInput() {
+  QPointF pointer_pos;
+  if (_input_queue.Latch(_input_clock.nsecsElapsed(), &pointer_pos) &&
+      _drag_board != kNoBoard) {
+    Board &board = *_boards[_drag_board];
+    QPointF mouse_coords = CoordsWindowToGame(board, pointer_pos);
+    board.logic.MouseMove(mouse_coords.x(), mouse_coords.y());
+  }
+
+  for (auto &touch : _touch_points) {
+    TouchPoint &point = touch.second;
+    if (point.moved) {
+      Board &board = *_boards[point.board];
+      QPointF touch_coords = CoordsWindowToGame(board, point.pos);
+      board.logic.PointerMove(touch.first, touch_coords.x(), touch_coords.y());
+      point.moved = false;
+    }
+  }
+  // releases of the same frame are resolved as one batch per board
+  for (int i = 0; i < static_cast<int>(_boards.size()); i++) {
+    if (!_touch_releases[i].empty()) {
+      _boards[i]->logic.PointerRelease(_touch_releases[i]);
+      _touch_releases[i].clear();
+    }
+  }
+}
+
+void GraphicsEngine::FitCameraToBoard(Board &board) {
+  board.game_width = board.logic.width();
+  board.game_height = board.logic.height();
+  board.camera.FitBoard(board.game_width, board.game_height);
+}
+
+void GraphicsEngine::LayoutBoards() {
+  int count = _boards.size();
+  int columns = std::ceil(std::sqrt(static_cast<float>(count)));
+  int rows = (count + columns - 1) / columns;
+  for (int i = 0; i < count; i++) {
+    Board &board = *_boards[i];
+    int column = i % columns;
+    int row = i / columns;
+    int left = column * _view_width / columns;
+    int right = (column + 1) * _view_width / columns;
+    int top = row * _view_height / rows;
+    int bottom = (row + 1) * _view_height / rows;
+    board.region = QRect(left, top, right - left, bottom - top);
+    board.camera.SetViewport(board.region.width(), board.region.height());
+
+    // maps the region's normalized coordinates into the window's, all
+    // boards draw in the same pass and are clipped to their region
+    QRectF clip(2.0f * left / _view_width - 1.0f,
+                1.0f - 2.0f * bottom / _view_height,
+                2.0f * board.region.width() / _view_width,
+                2.0f * board.region.height() / _view_height);
+    QMatrix4x4 region_matrix;
+    region_matrix.translate(clip.center().x(), clip.center().y());
+    region_matrix.scale(clip.width() / 2.0f, clip.height() / 2.0f);
+    board.renderer.SetProjection(
+        region_matrix *
+            SquareProjection(board.region.width(), board.region.height()),
+        count > 1 ? clip : QRectF());
+  }
 }
 
 void GraphicsEngine::initializeGL() {
+  MarkStartupPhase("context");
   _opengl_mutex.lock();
   initializeOpenGLFunctions();
 
@@ -108,245 +321,301 @@ void GraphicsEngine::initializeGL() {
   glEnable(GL_BLEND);
   glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-  LoadTextures();
-  CompileShaders();
-  GenerateBuffers();
-  _board_renderer.Init();
+  _render_queue.Init();
+  _render_queue.SetProjection(_projection_matrix);
+
+  // only wait for what the first frame needs
+  _background_texture = _assets.CreateTexture(kBackgroundImage);
+  _assets.BuildProgram(_program_background,
+                       ":/GL_shaders/background_vs.glsl",
+                       ":/GL_shaders/background_fs.glsl");
+  _render_queue.AttachProgram(_program_background);
+  GenerateBackgroundBuffers();
+  _layer_cache.Init();
 
   _is_initialized = true;
   _opengl_mutex.unlock();
+  MarkStartupPhase("background");
 
   emit Initialized();
 }
 
-void GraphicsEngine::LoadTextures() {
-  _background_texture = new QOpenGLTexture(QImage(":/images/tux_square.png"));
-  _background_texture->setMinificationFilter(QOpenGLTexture::Linear);
-  _background_texture->setMagnificationFilter(QOpenGLTexture::Linear);
-  _background_texture->setWrapMode(QOpenGLTexture::Repeat);
-
-  _title_texture = new QOpenGLTexture(QImage(":/images/title.png"));
-  _title_texture->setMinificationFilter(QOpenGLTexture::Linear);
-  _title_texture->setMagnificationFilter(QOpenGLTexture::Linear);
-  _title_texture->setWrapMode(QOpenGLTexture::Repeat);
+void GraphicsEngine::FinishLoading() {
+  _opengl_mutex.lock();
+  _title_texture = _assets.CreateTexture(kTitleImage);
+  _assets.BuildProgram(_program_title, ":/GL_shaders/title_vs.glsl",
+                       ":/GL_shaders/title_fs.glsl");
+  _render_queue.AttachProgram(_program_title);
+  _title_model_location = _program_title.uniformLocation("model");
+  GenerateTitleBuffers();
+  _board_resources.Init(_assets, _render_queue);
+  for (int i = 0; i < static_cast<int>(_boards.size()); i++) {
+    _boards[i]->renderer.Init(_board_resources, i);
+  }
+  _assets_loaded = true;
+  _opengl_mutex.unlock();
+  MarkStartupPhase("assets");
 }
 
-void GraphicsEngine::GenerateBuffers() {
+void GraphicsEngine::GenerateBackgroundBuffers() {
   _opengl_mutex.lock();
-  // setup background vao
-  {
-    glGenVertexArrays(1, &_background_vao);
-    glGenBuffers(1, &_background_vbo);
-
-    glBindVertexArray(_background_vao);
-    glBindBuffer(GL_ARRAY_BUFFER, _background_vbo);
-
-    _program_background.bind();
-    int pos_location = _program_background.attributeLocation("position");
-    glVertexAttribPointer(pos_location, 2, GL_FLOAT, GL_FALSE,
-                          4 * sizeof(float), reinterpret_cast<void *>(0));
-    glEnableVertexAttribArray(pos_location);
-
-    int tex_location = _program_background.attributeLocation("tex");
-    glVertexAttribPointer(tex_location, 2, GL_FLOAT, GL_FALSE,
-                          4 * sizeof(float),
-                          reinterpret_cast<void *>(2 * sizeof(float)));
-    glEnableVertexAttribArray(tex_location);
-
-    // fill buffer with data
-    GLfloat interleaved_background_buff[6 * 4] = {
-        -1.0, 1.0,   // poly 1 a
-        0.0,  0.0,   // poly 1 a tex
-        -1.0, -1.0,  // poly 1 b
-        0.0,  1.0,   // poly 1 b tex
-        1.0,  1.0,   // poly 1 c
-        1.0,  0.0,   // poly 1 c tex
-        1.0,  1.0,   // poly 2 a
-        1.0,  0.0,   // poly 2 a tex
-        -1.0, -1.0,  // poly 2 b
-        0.0,  1.0,   // poly 2 b tex
-        1.0,  -1.0,  // poly 2 c
-        1.0,  1.0    // poly 2 c tex
-    };
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 4,
-                 interleaved_background_buff, GL_STATIC_DRAW);
-
-    // bind texture
-    int tex_uniform = _program_background.uniformLocation("u_tex_background");
-    glUniform1i(tex_uniform, GL_TEXTURE0);
-    _program_background.release();
-  }
-  // setup title vao
-  {
-    glGenVertexArrays(1, &_title_vao);
-    glGenBuffers(1, &_title_vbo);
-
-    glBindVertexArray(_title_vao);
-    glBindBuffer(GL_ARRAY_BUFFER, _title_vbo);
-
-    _program_title.bind();
-    int pos_location = _program_title.attributeLocation("pos");
-    glVertexAttribPointer(pos_location, 2, GL_FLOAT, GL_FALSE,
-                          4 * sizeof(float), reinterpret_cast<void *>(0));
-    glEnableVertexAttribArray(pos_location);
-
-    int tex_location = _program_title.attributeLocation("tex");
-    glVertexAttribPointer(tex_location, 2, GL_FLOAT, GL_FALSE,
-                          4 * sizeof(float),
-                          reinterpret_cast<void *>(2 * sizeof(float)));
-    glEnableVertexAttribArray(tex_location);
-
-    // fill buffer with data
-    GLfloat interleaved_title_buff[6 * 4] = {
-        -0.8, 0.2,   // poly 1 a
-        0.0,  0.0,   // poly 1 a tex
-        -0.8, -0.2,  // poly 1 b
-        0.0,  1.0,   // poly 1 b tex
-        0.8,  0.2,   // poly 1 c
-        1.0,  0.0,   // poly 1 c tex
-        0.8,  0.2,   // poly 2 a
-        1.0,  0.0,   // poly 2 a tex
-        -0.8, -0.2,  // poly 2 b
-        0.0,  1.0,   // poly 2 b tex
-        0.8,  -0.2,  // poly 2 c
-        1.0,  1.0    // poly 2 c tex
-    };
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 4, interleaved_title_buff,
-                 GL_STATIC_DRAW);
-
-    // bind texture
-    int tex_uniform = _program_title.uniformLocation("tex_title");
-    glUniform1i(tex_uniform, GL_TEXTURE0);
-    _program_title.release();
-  }
+  glGenVertexArrays(1, &_background_vao);
+  glGenBuffers(1, &_background_vbo);
+
+  glBindVertexArray(_background_vao);
+  glBindBuffer(GL_ARRAY_BUFFER, _background_vbo);
+
+  _program_background.bind();
+  int pos_location = _program_background.attributeLocation("position");
+  glVertexAttribPointer(pos_location, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float),
+                        reinterpret_cast<void *>(0));
+  glEnableVertexAttribArray(pos_location);
+
+  int tex_location = _program_background.attributeLocation("tex");
+  glVertexAttribPointer(tex_location, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float),
+                        reinterpret_cast<void *>(2 * sizeof(float)));
+  glEnableVertexAttribArray(tex_location);
+
+  // fill buffer with data
+  GLfloat interleaved_background_buff[6 * 4] = {
+      -1.0, 1.0,   // poly 1 a
+      0.0,  0.0,   // poly 1 a tex
+      -1.0, -1.0,  // poly 1 b
+      0.0,  1.0,   // poly 1 b tex
+      1.0,  1.0,   // poly 1 c
+      1.0,  0.0,   // poly 1 c tex
+      1.0,  1.0,   // poly 2 a
+      1.0,  0.0,   // poly 2 a tex
+      -1.0, -1.0,  // poly 2 b
+      0.0,  1.0,   // poly 2 b tex
+      1.0,  -1.0,  // poly 2 c
+      1.0,  1.0    // poly 2 c tex
+  };
+  glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 4,
+               interleaved_background_buff, GL_STATIC_DRAW);
+
+  // bind texture
+  int tex_uniform = _program_background.uniformLocation("u_tex_background");
+  glUniform1i(tex_uniform, GL_TEXTURE0);
+  _program_background.release();
+  glBindVertexArray(0);
   _opengl_mutex.unlock();
 }
 
-void GraphicsEngine::CompileShaders() {
+void GraphicsEngine::GenerateTitleBuffers() {
   _opengl_mutex.lock();
-  // background shaders
-  {
-    QFile vs_file(":/GL_shaders/background_vs.glsl");
-    QFile fs_file(":/GL_shaders/background_fs.glsl");
-    vs_file.open(QIODevice::ReadOnly);
-    fs_file.open(QIODevice::ReadOnly);
-    QByteArray vs_source = vs_file.readAll();
-    QByteArray fs_source = fs_file.readAll();
-
-    if (QOpenGLContext::currentContext()->isOpenGLES()) {
-      vs_source.prepend(QByteArrayLiteral("#version 300 es\n"));
-      fs_source.prepend(QByteArrayLiteral("#version 300 es\n"));
-    } else {
-      vs_source.prepend(QByteArrayLiteral("#version 410\n"));
-      fs_source.prepend(QByteArrayLiteral("#version 410\n"));
-    }
+  glGenVertexArrays(1, &_title_vao);
+  glGenBuffers(1, &_title_vbo);
 
-    _program_background.addShaderFromSourceCode(QOpenGLShader::Vertex,
-                                                vs_source);
-    _program_background.addShaderFromSourceCode(QOpenGLShader::Fragment,
-                                                fs_source);
-    _program_background.link();
-  }
-  // title shaders
-  {
-    QFile vs_file(":/GL_shaders/title_vs.glsl");
-    QFile fs_file(":/GL_shaders/title_fs.glsl");
-    vs_file.open(QIODevice::ReadOnly);
-    fs_file.open(QIODevice::ReadOnly);
-    QByteArray vs_source = vs_file.readAll();
-    QByteArray fs_source = fs_file.readAll();
-
-    if (QOpenGLContext::currentContext()->isOpenGLES()) {
-      vs_source.prepend(QByteArrayLiteral("#version 300 es\n"));
-      fs_source.prepend(QByteArrayLiteral("#version 300 es\n"));
-    } else {
-      vs_source.prepend(QByteArrayLiteral("#version 410\n"));
-      fs_source.prepend(QByteArrayLiteral("#version 410\n"));
-    }
+  glBindVertexArray(_title_vao);
+  glBindBuffer(GL_ARRAY_BUFFER, _title_vbo);
 
-    _program_title.addShaderFromSourceCode(QOpenGLShader::Vertex, vs_source);
-    _program_title.addShaderFromSourceCode(QOpenGLShader::Fragment, fs_source);
-    _program_title.link();
-  }
+  _program_title.bind();
+  int pos_location = _program_title.attributeLocation("pos");
+  glVertexAttribPointer(pos_location, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float),
+                        reinterpret_cast<void *>(0));
+  glEnableVertexAttribArray(pos_location);
+
+  int tex_location = _program_title.attributeLocation("tex");
+  glVertexAttribPointer(tex_location, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float),
+                        reinterpret_cast<void *>(2 * sizeof(float)));
+  glEnableVertexAttribArray(tex_location);
+
+  // fill buffer with data
+  GLfloat interleaved_title_buff[6 * 4] = {
+      -0.8, 0.2,   // poly 1 a
+      0.0,  0.0,   // poly 1 a tex
+      -0.8, -0.2,  // poly 1 b
+      0.0,  1.0,   // poly 1 b tex
+      0.8,  0.2,   // poly 1 c
+      1.0,  0.0,   // poly 1 c tex
+      0.8,  0.2,   // poly 2 a
+      1.0,  0.0,   // poly 2 a tex
+      -0.8, -0.2,  // poly 2 b
+      0.0,  1.0,   // poly 2 b tex
+      0.8,  -0.2,  // poly 2 c
+      1.0,  1.0    // poly 2 c tex
+  };
+  glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 4, interleaved_title_buff,
+               GL_STATIC_DRAW);
+
+  // bind texture
+  int tex_uniform = _program_title.uniformLocation("tex_title");
+  glUniform1i(tex_uniform, GL_TEXTURE0);
+  _program_title.release();
+  glBindVertexArray(0);
   _opengl_mutex.unlock();
 }
 
+void GraphicsEngine::MarkStartupPhase(const char *phase) {
+  _startup_phases.push_back({phase, _startup_clock.elapsed()});
+}
+
+void GraphicsEngine::ReportStartup() {
+  // milliseconds since construction at the end of each phase
+  std::cout << "startup:";
+  for (const auto &phase : _startup_phases) {
+    std::cout << " " << phase.first << " " << phase.second << "ms";
+  }
+  std::cout << std::endl;
+  _startup_reported = true;
+}
+
+void GraphicsEngine::ReportAllocations() {
+  // heap allocations of the logic ticks and frames since the last report
+  std::cout << "allocations: "
+            << static_cast<float>(_frame_allocations) / _allocation_frames
+            << " per frame over " << _allocation_frames << " frames"
+            << std::endl;
+  _frame_allocations = 0;
+  _allocation_frames = 0;
+}
+
 void GraphicsEngine::resizeGL(int width, int height) {
   _opengl_mutex.lock();
-  _view_width = width;
-  _view_height = height;
+  _view_width = std::max(width, 1);
+  _view_height = std::max(height, 1);
   glViewport(0, 0, width, height);
 
-  // ensure squareness
-  float aspect_ratio = (float)width / (float)height;
-  _projection_matrix.setToIdentity();
-  if (aspect_ratio > 1.0f) {
-    // wide viewport, use full height
-    _projection_matrix.ortho(-aspect_ratio, aspect_ratio, -1.0f, 1.0f, 0.0f,
-                             10.0f);
-  } else {
-    // tall viewport, use full width
-    _projection_matrix.ortho(-1.0f, 1.0f, -1.0f / aspect_ratio,
-                             1.0f / aspect_ratio, 0.0f, 10.0f);
-  }
-
-  _board_renderer.SetProjection(_projection_matrix);
+  _projection_matrix = SquareProjection(_view_width, _view_height);
+  LayoutBoards();
+  _render_queue.SetProjection(_projection_matrix);
+  _layer_cache.Resize(width, height);
   _opengl_mutex.unlock();
 }
 
 void GraphicsEngine::paintGL() {
   if (_is_initialized) {
     _opengl_mutex.lock();
+    uint64_t allocations = AllocationCounter::Count();
+    QElapsedTimer work_clock;
+    work_clock.start();
+    // frames while loading say nothing about the steady frame time
+    bool measure_frame = _assets_loaded && _frame_clock.isValid();
+    float interval_ms = _frame_clock.isValid()
+                            ? _frame_clock.nsecsElapsed() / 1000000.0f
+                            : 0.0f;
+    _frame_clock.start();
+    if (!_assets_loaded && _assets.Ready()) {
+      FinishLoading();
+    }
+    LatchInput();
+    const QualityGovernor::Settings &quality = _quality.settings();
+    _layer_cache.SetScale(quality.render_scale);
+    GLuint screen_framebuffer = defaultFramebufferObject();
+    // reduced resolution frames are drawn offscreen and upsampled at the end
+    GLuint frame_framebuffer = screen_framebuffer;
+    if (_layer_cache.scaled()) {
+      frame_framebuffer = _layer_cache.framebuffer(LayerCache::kFrame);
+    }
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    float score = static_cast<float>(_game_logic.score()) /
-                  static_cast<float>(_game_logic.goal());
-    switch (_game_logic.state()) {
-      case GameLogic::kPlaying: {
-        DrawBackground(true, score);
-        _board_renderer.Render(_game_logic.board());
-        break;
+    // boards are shown unless paused, the score shaded background and the
+    // title follow the first board
+    const GameLogic &first_logic = _boards.front()->logic;
+    GameLogic::GameState state = first_logic.state();
+    bool score_mode = state != GameLogic::kPaused && _assets_loaded;
+    bool score_effect = score_mode && quality.score_effect;
+    float score = static_cast<float>(first_logic.score()) /
+                  static_cast<float>(first_logic.goal());
+    // bit i is set when board i is shown
+    quint64 shown_boards = 0;
+    quint64 static_versions = 0;
+    for (int i = 0; i < static_cast<int>(_boards.size()); i++) {
+      Board &board = *_boards[i];
+      if (board.logic.state() != GameLogic::kPaused && _assets_loaded) {
+        shown_boards |= 1ull << i;
+        board.renderer.Update(board.logic.board(), board.camera);
       }
-      case GameLogic::kPaused: {
-        DrawBackground(false);
-        DrawTitle();
-        break;
+      static_versions += board.renderer.static_version();
+    }
+
+    // the background only changes with the score
+    quint64 background_key = (static_cast<quint64>(score_effect) << 63) |
+                             (static_cast<quint64>(first_logic.score()) << 32) |
+                             static_cast<quint32>(first_logic.goal());
+    if (_layer_cache.Begin(LayerCache::kBackground, background_key)) {
+      DrawBackground(score_effect, score);
+      _render_queue.Flush();
+      _layer_cache.End(frame_framebuffer);
+      _layer_cache.Invalidate(LayerCache::kScene);
+    }
+
+    // The scene is the background with the stationary tiles of every board
+    // on top. Static versions only grow, so their sum changes with any board.
+    quint64 scene_key =
+        (static_versions << RenderQueue::kMaxViews) | shown_boards;
+    if (_layer_cache.Begin(LayerCache::kScene, scene_key)) {
+      _layer_cache.Copy(LayerCache::kBackground, LayerCache::kScene);
+      for (int i = 0; i < static_cast<int>(_boards.size()); i++) {
+        if (shown_boards & (1ull << i)) {
+          _boards[i]->renderer.RenderStatic(_render_queue);
+        }
       }
-      case GameLogic::kLevelComplete: {
-        DrawBackground(true, score);
-        _board_renderer.Render(_game_logic.board());
-        DrawTitle();
-        break;
+      _render_queue.Flush();
+      _layer_cache.End(frame_framebuffer);
+    }
+    _layer_cache.Present(LayerCache::kScene, frame_framebuffer);
+
+    for (int i = 0; i < static_cast<int>(_boards.size()); i++) {
+      if (shown_boards & (1ull << i)) {
+        Board &board = *_boards[i];
+        board.renderer.RenderDynamic(board.logic.board(), board.camera,
+                                     _render_queue);
       }
     }
+    if (state != GameLogic::kPlaying && _assets_loaded) {
+      DrawTitle(quality.title_tick_interval);
+    }
+    _render_queue.Flush();
+    if (frame_framebuffer != screen_framebuffer) {
+      _layer_cache.Upsample(LayerCache::kFrame, screen_framebuffer);
+    }
 
+    if (measure_frame) {
+      float work_ms = work_clock.nsecsElapsed() / 1000000.0f;
+      _quality.AddFrame(interval_ms, work_ms);
+      _frame_allocations += AllocationCounter::Count() - allocations;
+      if (AllocationCounter::Enabled() &&
+          ++_allocation_frames == kAllocationReportFrames) {
+        ReportAllocations();
+      }
+    }
     _opengl_mutex.unlock();
+    if (!_first_frame_drawn) {
+      _first_frame_drawn = true;
+      MarkStartupPhase("first frame");
+    }
+    if (!_startup_reported && _assets_loaded) {
+      ReportStartup();
+    }
   }
 }
 
 void GraphicsEngine::DrawBackground(bool score_mode, float score_percentage) {
   _opengl_mutex.lock();
 
-  glBindVertexArray(_background_vao);
-  _program_background.bind();
-  _program_background.setUniformValue("transform", _projection_matrix);
-  _program_background.setUniformValue("score_mode", score_mode);
-  _program_background.setUniformValue("score", score_percentage);
-  _background_texture->bind(GL_TEXTURE0);
-  glDrawArrays(GL_TRIANGLES, 0, 6);
-  _background_texture->release();
-  _program_background.release();
-  glBindVertexArray(0);
+  _render_queue.SetScore(score_mode, score_percentage);
+  _render_queue.Submit({RenderQueue::kOpaque,
+                        &_program_background,
+                        {{_background_texture->textureId(), 0}},
+                        _background_vao,
+                        RenderQueue::kNoView,
+                        6,
+                        0,
+                        {},
+                        {}});
 
   _opengl_mutex.unlock();
 }
 
-void GraphicsEngine::DrawTitle() {
-  float hover = sin(static_cast<float>(_tick) / (kTitleHoverPeriod * kFPS)) *
-                kTitleHoverRange;
+void GraphicsEngine::DrawTitle(int tick_interval) {
+  // the animation only advances every tick_interval ticks
+  float tick = _tick - _tick % tick_interval;
+  float hover = sin(tick / (kTitleHoverPeriod * kFPS)) * kTitleHoverRange;
   hover += kTitleHoverAt;
-  float angle = sin(static_cast<float>(_tick) / (kTitleRotationPeriod * kFPS)) *
-                kTitleRotationRange;
+  float angle =
+      sin(tick / (kTitleRotationPeriod * kFPS)) * kTitleRotationRange;
 
   QMatrix4x4 transform;
   transform.translate(0, hover);
@@ -354,14 +623,19 @@ void GraphicsEngine::DrawTitle() {
 
   _opengl_mutex.lock();
 
-  glBindVertexArray(_title_vao);
-  _program_title.bind();
-  _program_title.setUniformValue("transform", _projection_matrix * transform);
-  _title_texture->bind(GL_TEXTURE0);
-  glDrawArrays(GL_TRIANGLES, 0, 6);
-  _title_texture->release();
-  _program_title.release();
-  glBindVertexArray(0);
+  const QMatrix4x4 *title_transform = _render_queue.FrameData(transform);
+  _render_queue.Submit({RenderQueue::kOverlay,
+                        &_program_title,
+                        {{_title_texture->textureId(), 0}},
+                        _title_vao,
+                        RenderQueue::kNoView,
+                        6,
+                        0,
+                        [this, title_transform]() {
+                          _program_title.setUniformValue(
+                              _title_model_location, *title_transform);
+                        },
+                        {}});
 
   _opengl_mutex.unlock();
 }
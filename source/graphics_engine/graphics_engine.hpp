@@ -1,25 +1,40 @@
 #ifndef SOURCE_GRAPHICS_ENGINE_GRAPHICS_ENGINE_HPP_
 #define SOURCE_GRAPHICS_ENGINE_GRAPHICS_ENGINE_HPP_
 
+#include <QElapsedTimer>
 #include <QMutex>
 #include <QOpenGLExtraFunctions>
 #include <QOpenGLShaderProgram>
 #include <QOpenGLTexture>
 #include <QOpenGLWindow>
 #include <QPoint>
+#include <QRect>
 #include <QString>
 #include <QTimer>
 #include <QVector2D>
 #include <QVector3D>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
+#include "asset_loader.hpp"
 #include "board_renderer.hpp"
+#include "board_resources.hpp"
+#include "camera.hpp"
+#include "input_queue.hpp"
+#include "layer_cache.hpp"
+#include "quality_governor.hpp"
+#include "render_queue.hpp"
+#include "game_logic/frame_arena.hpp"
 #include "game_logic/game_logic.hpp"
 
 class GraphicsEngine final : public QOpenGLWindow,
                              protected QOpenGLExtraFunctions {
   Q_OBJECT
  public:
-  explicit GraphicsEngine();
+  // boards are played side by side, up to RenderQueue::kMaxViews
+  explicit GraphicsEngine(int board_count = 1);
   ~GraphicsEngine();
 
   // QOpenGLWindow reimplemented functions
@@ -28,6 +43,18 @@ class GraphicsEngine final : public QOpenGLWindow,
   void paintGL() override;
   QSize minimumSizeHint() const;
   QSize sizeHint() const;
+  // extrapolate dragging this far ahead to hide input latency, 0 disables
+  void SetInputPrediction(float milliseconds);
+  // every board starts from the same seed, so players race on equal boards
+  void SetSeed(uint64_t seed);
+  // fixes the render quality, see QualityGovernor
+  void SetQuality(int level);
+  // publishes every board to shared memory for observers, the first board
+  // under name and the others under name_<index>, see StatePublisher
+  bool PublishState(const QString &name);
+  // every board plays the levels of the pack at path, see
+  // GameLogic::UseLevelPack
+  bool LoadLevelPack(const QString &path);
 
  public slots:
   void ExecuteFrame();
@@ -36,19 +63,55 @@ class GraphicsEngine final : public QOpenGLWindow,
   void mousePressEvent(QMouseEvent *event) override;
   void mouseMoveEvent(QMouseEvent *event) override;
   void mouseReleaseEvent(QMouseEvent *event) override;
+  void wheelEvent(QWheelEvent *event) override;
+  // every touch point drags on its own, see GameLogic::PointerPress
+  void touchEvent(QTouchEvent *event) override;
+  // undo and redo apply to the board clicked last
+  void keyPressEvent(QKeyEvent *event) override;
 
  signals:
   void Initialized();
 
  private:
-  float Remap(float min_old, float max_old, float min_new, float max_new,
-              float value);
-  QPointF CoordsWindowToGame(QPoint mouse_pos);
-  void LoadTextures();
-  void GenerateBuffers();
-  void CompileShaders();
+  // one game with its own camera, drawn into a region of the window
+  typedef struct {
+    GameLogic logic;
+    BoardRenderer renderer;
+    Camera camera;
+    // window pixels, y pointing down
+    QRect region;
+    int game_width;
+    int game_height;
+  } Board;
+
+  typedef struct {
+    int board;
+    // window position, moves are applied once per frame like mouse moves
+    QPointF pos;
+    bool moved;
+  } TouchPoint;
+
+  static constexpr int kNoBoard = -1;
+
+  static QMatrix4x4 SquareProjection(int width, int height);
+  // index of the board whose region contains the window position
+  int BoardAt(QPoint window_pos) const;
+  QPointF CoordsWindowToGame(const Board &board, QPointF mouse_pos);
+  void LatchInput();
+  void FitCameraToBoard(Board &board);
+  // splits the window into a grid of regions, one per board
+  void LayoutBoards();
+  // everything but the background is set up once its assets arrived, the
+  // first frames show only the background
+  void FinishLoading();
+  void GenerateBackgroundBuffers();
+  void GenerateTitleBuffers();
+  void MarkStartupPhase(const char *phase);
+  void ReportStartup();
+  // only when built to count allocations, see AllocationCounter
+  void ReportAllocations();
   void DrawBackground(bool score_mode, float score_percentage = 0.0f);
-  void DrawTitle();
+  void DrawTitle(int tick_interval);
 
   static constexpr int kFPS = 60;
   static constexpr float kTitleRotationRange = 5.0f;
@@ -56,11 +119,37 @@ class GraphicsEngine final : public QOpenGLWindow,
   static constexpr float kTitleHoverRange = 0.1f;
   static constexpr float kTitleHoverAt = -0.4f;
   static constexpr float kTitleHoverPeriod = 2;
+  static constexpr float kZoomStep = 1.1f;
+  static constexpr int kAllocationReportFrames = 10 * kFPS;
+  static constexpr const char *kBackgroundImage = ":/images/tux_square.png";
+  static constexpr const char *kTitleImage = ":/images/title.png";
 
-  GameLogic _game_logic;
-  BoardRenderer _board_renderer;
-  int _game_width;
-  int _game_height;
+  std::vector<std::unique_ptr<Board>> _boards;
+  BoardResources _board_resources;
+  // board receiving the current drag and pan, and the one clicked last
+  int _drag_board;
+  int _pan_board;
+  int _focus_board;
+  // active touch points by touch id
+  std::unordered_map<int, TouchPoint> _touch_points;
+  // touch releases since the last frame per board, resolved together
+  std::vector<std::vector<GameBoard::Release>> _touch_releases;
+  LayerCache _layer_cache;
+  RenderQueue _render_queue;
+  QualityGovernor _quality;
+  QElapsedTimer _frame_clock;
+  QPoint _pan_last_pos;
+  InputQueue _input_queue;
+  QElapsedTimer _input_clock;
+  AssetLoader _assets;
+  bool _assets_loaded;
+  QElapsedTimer _startup_clock;
+  std::vector<std::pair<const char *, qint64>> _startup_phases;
+  bool _startup_reported;
+  bool _first_frame_drawn;
+  // heap allocations since the last report, and the frames drawn since
+  uint64_t _frame_allocations;
+  int _allocation_frames;
   QTimer _frame_timer;
   int _tick;
   bool _is_initialized;
@@ -76,6 +165,7 @@ class GraphicsEngine final : public QOpenGLWindow,
   QOpenGLTexture *_title_texture;
   QOpenGLShaderProgram _program_background;
   QOpenGLShaderProgram _program_title;
+  int _title_model_location;
 };
 
 #endif  // SOURCE_GRAPHICS_ENGINE_GRAPHICS_ENGINE_HPP_
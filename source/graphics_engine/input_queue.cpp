@@ -0,0 +1,61 @@
+#include "input_queue.hpp"
+
+#include <algorithm>
+
+InputQueue::InputQueue()
+    : _history(),
+      _count(0),
+      _newest(0),
+      _pending(false),
+      _prediction_horizon_ms(0.0f) {}
+
+void InputQueue::SetPredictionHorizon(float milliseconds) {
+  _prediction_horizon_ms = std::clamp(milliseconds, 0.0f, kMaxPredictionMs);
+}
+
+void InputQueue::Reset() {
+  _count = 0;
+  _pending = false;
+}
+
+void InputQueue::PushMove(QPointF pos, qint64 timestamp_ns) {
+  _newest = (_newest + 1) % kHistorySize;
+  _history[_newest] = {pos, timestamp_ns};
+  _count = std::min(_count + 1, kHistorySize);
+  _pending = true;
+}
+
+bool InputQueue::Latch(qint64 now_ns, QPointF *pos) {
+  if (!_pending) {
+    return false;
+  }
+  _pending = false;
+  *pos = _prediction_horizon_ms > 0.0f ? Predict(now_ns)
+                                       : _history[_newest].pos;
+  return true;
+}
+
+QPointF InputQueue::Predict(qint64 now_ns) const {
+  // velocity between the newest sample and the oldest one inside the window
+  const Sample &newest = _history[_newest];
+  const Sample *oldest = &newest;
+  for (int i = 1; i < _count; i++) {
+    const Sample &sample =
+        _history[(_newest - i + kHistorySize) % kHistorySize];
+    if (newest.timestamp_ns - sample.timestamp_ns > kVelocityWindowNs) {
+      break;
+    }
+    oldest = &sample;
+  }
+  qint64 elapsed_ns = newest.timestamp_ns - oldest->timestamp_ns;
+  if (elapsed_ns <= 0) {
+    return newest.pos;
+  }
+
+  // extrapolate from the newest sample up to the horizon past now
+  float horizon_ns = (now_ns - newest.timestamp_ns) +
+                     _prediction_horizon_ms * 1000000.0f;
+  horizon_ns = std::min(horizon_ns, kMaxPredictionMs * 1000000.0f);
+  QPointF velocity = (newest.pos - oldest->pos) * (1.0 / elapsed_ns);
+  return newest.pos + velocity * horizon_ns;
+}
@@ -0,0 +1,40 @@
+#ifndef SOURCE_GRAPHICS_ENGINE_INPUT_QUEUE_HPP_
+#define SOURCE_GRAPHICS_ENGINE_INPUT_QUEUE_HPP_
+
+#include <QPointF>
+#include <QtGlobal>
+#include <array>
+
+// Coalesces pointer move events between frames. Moves are only recorded when
+// they arrive, and the newest position is latched once per frame right before
+// rendering, optionally extrapolated a short time ahead.
+class InputQueue {
+ public:
+  InputQueue();
+
+  void SetPredictionHorizon(float milliseconds);
+  void Reset();
+  void PushMove(QPointF pos, qint64 timestamp_ns);
+  // false when the pointer did not move since the previous latch
+  bool Latch(qint64 now_ns, QPointF *pos);
+
+ private:
+  typedef struct {
+    QPointF pos;
+    qint64 timestamp_ns;
+  } Sample;
+
+  QPointF Predict(qint64 now_ns) const;
+
+  static constexpr int kHistorySize = 8;
+  static constexpr qint64 kVelocityWindowNs = 50000000;
+  static constexpr float kMaxPredictionMs = 50.0f;
+
+  std::array<Sample, kHistorySize> _history;
+  int _count;
+  int _newest;
+  bool _pending;
+  float _prediction_horizon_ms;
+};
+
+#endif  // SOURCE_GRAPHICS_ENGINE_INPUT_QUEUE_HPP_
@@ -0,0 +1,83 @@
+#include "layer_cache.hpp"
+
+#include <algorithm>
+
+LayerCache::LayerCache()
+    : _window_width(1),
+      _window_height(1),
+      _scale(1.0f),
+      _width(1),
+      _height(1),
+      _keys(),
+      _valid() {}
+
+LayerCache::~LayerCache() {}
+
+void LayerCache::Init() { initializeOpenGLFunctions(); }
+
+void LayerCache::Resize(int width, int height) {
+  _window_width = std::max(width, 1);
+  _window_height = std::max(height, 1);
+  _width = std::max(static_cast<int>(_window_width * _scale), 1);
+  _height = std::max(static_cast<int>(_window_height * _scale), 1);
+  for (int layer = 0; layer < kLayerCount; layer++) {
+    _framebuffers[layer] = std::make_unique<QOpenGLFramebufferObject>(
+        QSize(_width, _height));
+    _valid[layer] = false;
+  }
+}
+
+void LayerCache::SetScale(float scale) {
+  if (scale != _scale) {
+    _scale = scale;
+    Resize(_window_width, _window_height);
+  }
+}
+
+void LayerCache::Invalidate(Layer layer) { _valid[layer] = false; }
+
+bool LayerCache::Begin(Layer layer, quint64 key) {
+  if (!_framebuffers[layer]) {
+    Resize(_window_width, _window_height);
+  }
+  if (_valid[layer] && _keys[layer] == key) {
+    return false;
+  }
+
+  _keys[layer] = key;
+  _valid[layer] = true;
+  glBindFramebuffer(GL_FRAMEBUFFER, _framebuffers[layer]->handle());
+  glViewport(0, 0, _width, _height);
+  glClear(GL_COLOR_BUFFER_BIT);
+  return true;
+}
+
+void LayerCache::End(GLuint target_framebuffer) {
+  glBindFramebuffer(GL_FRAMEBUFFER, target_framebuffer);
+}
+
+void LayerCache::Copy(Layer source, Layer destination) {
+  Blit(_framebuffers[source]->handle(), _framebuffers[destination]->handle());
+}
+
+void LayerCache::Present(Layer source, GLuint target_framebuffer) {
+  Blit(_framebuffers[source]->handle(), target_framebuffer);
+  glViewport(0, 0, _width, _height);
+}
+
+void LayerCache::Upsample(Layer source, GLuint target_framebuffer) {
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, _framebuffers[source]->handle());
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, target_framebuffer);
+  glBlitFramebuffer(0, 0, _width, _height, 0, 0, _window_width,
+                    _window_height, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+  glBindFramebuffer(GL_FRAMEBUFFER, target_framebuffer);
+  glViewport(0, 0, _window_width, _window_height);
+}
+
+void LayerCache::Blit(GLuint source_framebuffer, GLuint target_framebuffer) {
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, source_framebuffer);
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, target_framebuffer);
+  glBlitFramebuffer(0, 0, _width, _height, 0, 0, _width, _height,
+                    GL_COLOR_BUFFER_BIT, GL_NEAREST);
+  glBindFramebuffer(GL_FRAMEBUFFER, target_framebuffer);
+}
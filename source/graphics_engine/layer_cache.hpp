@@ -0,0 +1,54 @@
+#ifndef SOURCE_GRAPHICS_ENGINE_LAYER_CACHE_HPP_
+#define SOURCE_GRAPHICS_ENGINE_LAYER_CACHE_HPP_
+
+#include <QOpenGLExtraFunctions>
+#include <QOpenGLFramebufferObject>
+#include <array>
+#include <memory>
+
+// Offscreen copies of the parts of a frame that rarely change. A layer is
+// only redrawn when the key it was drawn with changes, otherwise it is copied
+// to the target framebuffer with a blit. With a scale below 1 the layers are
+// smaller than the window, the frame is then drawn into kFrame and upsampled
+// to the window by Upsample.
+class LayerCache : protected QOpenGLExtraFunctions {
+ public:
+  enum Layer { kBackground = 0, kScene, kFrame, kLayerCount };
+
+  LayerCache();
+  ~LayerCache();
+
+  void Init();
+  void Resize(int width, int height);
+  void SetScale(float scale);
+  bool scaled() const { return _width != _window_width; }
+  GLuint framebuffer(Layer layer) const {
+    return _framebuffers[layer]->handle();
+  }
+  void Invalidate(Layer layer);
+
+  // Returns true and binds the layer framebuffer when the layer has to be
+  // redrawn, the caller then draws it and calls End.
+  bool Begin(Layer layer, quint64 key);
+  void End(GLuint target_framebuffer);
+  void Copy(Layer source, Layer destination);
+  void Present(Layer source, GLuint target_framebuffer);
+  // blits a layer to the window sized target with filtering
+  void Upsample(Layer source, GLuint target_framebuffer);
+
+ private:
+  void Blit(GLuint source_framebuffer, GLuint target_framebuffer);
+
+  int _window_width;
+  int _window_height;
+  float _scale;
+  // layer size, the window size times the scale
+  int _width;
+  int _height;
+  std::array<std::unique_ptr<QOpenGLFramebufferObject>, kLayerCount>
+      _framebuffers;
+  std::array<quint64, kLayerCount> _keys;
+  std::array<bool, kLayerCount> _valid;
+};
+
+#endif  // SOURCE_GRAPHICS_ENGINE_LAYER_CACHE_HPP_
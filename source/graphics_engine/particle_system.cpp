@@ -0,0 +1,161 @@
+#include "particle_system.hpp"
+
+#include <QOpenGLContext>
+#include <algorithm>
+
+ParticleSystem::ParticleSystem()
+    : _vaos(),
+      _buffers(),
+      _current(0),
+      _emitter_ubo(0),
+      _emit_start(0),
+      _frame(0),
+      _idle_time(kMaxLife),
+      _program(nullptr),
+      _time_step_location(0),
+      _emit_start_location(0),
+      _emit_count_location(0),
+      _seed_location(0),
+      _point_size_location(0) {}
+
+ParticleSystem::~ParticleSystem() {}
+
+QStringList ParticleSystem::ShaderPaths() {
+  return {":/GL_shaders/particles_vs.glsl", ":/GL_shaders/particles_fs.glsl"};
+}
+
+void ParticleSystem::BuildProgram(QOpenGLShaderProgram &program,
+                                  AssetLoader &assets) {
+  QOpenGLContext *context = QOpenGLContext::currentContext();
+  QOpenGLExtraFunctions *gl = context->extraFunctions();
+#ifdef GL_PROGRAM_POINT_SIZE
+  // always enabled on GLES
+  if (!context->isOpenGLES()) {
+    gl->glEnable(GL_PROGRAM_POINT_SIZE);
+  }
+#endif
+
+  assets.BuildProgram(program, ":/GL_shaders/particles_vs.glsl",
+                      ":/GL_shaders/particles_fs.glsl",
+                      {"tf_motion", "tf_life_cell"});
+  GLuint program_id = program.programId();
+  GLuint emitter_index =
+      gl->glGetUniformBlockIndex(program_id, "ParticleEmitters");
+  gl->glUniformBlockBinding(program_id, emitter_index, kEmitterBinding);
+
+  program.bind();
+  gl->glUniform1i(program.uniformLocation("u_tex_pieces"), 0);
+  gl->glUniform1i(program.uniformLocation("u_max_particles"), kMaxParticles);
+  gl->glUniform1i(program.uniformLocation("u_particles_per_emitter"),
+                  kParticlesPerEmitter);
+  program.release();
+}
+
+void ParticleSystem::Init(QOpenGLShaderProgram *program) {
+  initializeOpenGLFunctions();
+
+  _program = program;
+  _time_step_location = _program->uniformLocation("u_time_step");
+  _emit_start_location = _program->uniformLocation("u_emit_start");
+  _emit_count_location = _program->uniformLocation("u_emit_count");
+  _seed_location = _program->uniformLocation("u_seed");
+  _point_size_location = _program->uniformLocation("u_point_size");
+
+  glGenBuffers(1, &_emitter_ubo);
+  glBindBuffer(GL_UNIFORM_BUFFER, _emitter_ubo);
+  glBufferData(GL_UNIFORM_BUFFER, sizeof(QVector4D) * kMaxEmitters, nullptr,
+               GL_DYNAMIC_DRAW);
+  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+  // all particles start out dead, with zero life
+  std::vector<GLfloat> particles(kMaxParticles * kParticleFloats, 0.0f);
+  int motion_location = _program->attributeLocation("motion");
+  int life_cell_location = _program->attributeLocation("life_cell");
+  GLsizei stride = kParticleFloats * sizeof(GLfloat);
+  glGenVertexArrays(2, _vaos.data());
+  glGenBuffers(2, _buffers.data());
+  for (int i = 0; i < 2; i++) {
+    glBindVertexArray(_vaos[i]);
+    glBindBuffer(GL_ARRAY_BUFFER, _buffers[i]);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * particles.size(),
+                 particles.data(), GL_STREAM_COPY);
+    glVertexAttribPointer(motion_location, 4, GL_FLOAT, GL_FALSE, stride,
+                          reinterpret_cast<void *>(0));
+    glEnableVertexAttribArray(motion_location);
+    glVertexAttribPointer(life_cell_location, 2, GL_FLOAT, GL_FALSE, stride,
+                          reinterpret_cast<void *>(4 * sizeof(GLfloat)));
+    glEnableVertexAttribArray(life_cell_location);
+  }
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glBindVertexArray(0);
+}
+
+void ParticleSystem::Emit(const QVector4D &emitter) {
+  if (_emitters.size() < kMaxEmitters) {
+    _emitters.push_back(emitter);
+  }
+}
+
+void ParticleSystem::Render(const QMatrix4x4 &transform, GLuint texture,
+                            int view, RenderQueue &queue) {
+  float time_step = 0.0f;
+  if (_clock.isValid()) {
+    time_step = std::min(_clock.nsecsElapsed() / 1000000000.0f, kMaxTimeStep);
+  }
+  _clock.start();
+
+  int emit_count = _emitters.size() * kParticlesPerEmitter;
+  if (emit_count > 0) {
+    glBindBuffer(GL_UNIFORM_BUFFER, _emitter_ubo);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0,
+                    sizeof(QVector4D) * _emitters.size(), _emitters.data());
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    _emitters.clear();
+    _idle_time = 0.0f;
+  } else {
+    // particles age by the same steps, so all of them are dead by now
+    _idle_time += time_step;
+    if (_idle_time > kMaxLife) {
+      return;
+    }
+  }
+
+  int next = 1 - _current;
+  const StepParameters *step = queue.FrameData(StepParameters{
+      transform, time_step, _emit_start, emit_count, _frame});
+  GLuint feedback_buffer = _buffers[next];
+  queue.Submit({RenderQueue::kParticles,
+                _program,
+                {{texture, 0}},
+                _vaos[_current],
+                view,
+                kMaxParticles,
+                0,
+                [this, step]() {
+                  // sprites scale with the board, one unit is one tile
+                  GLint viewport[4];
+                  glGetIntegerv(GL_VIEWPORT, viewport);
+                  float tile_pixels =
+                      step->transform(0, 0) * viewport[2] / 2.0f;
+                  glBindBufferBase(GL_UNIFORM_BUFFER, kEmitterBinding,
+                                   _emitter_ubo);
+                  glUniform1f(_time_step_location, step->time_step);
+                  glUniform1i(_emit_start_location, step->emit_start);
+                  glUniform1i(_emit_count_location, step->emit_count);
+                  glUniform1i(_seed_location, step->seed);
+                  glUniform1f(_point_size_location,
+                              tile_pixels * kParticleSize);
+                },
+                [this, feedback_buffer]() {
+                  glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0,
+                                   feedback_buffer);
+                  glBeginTransformFeedback(GL_POINTS);
+                  glDrawArrays(GL_POINTS, 0, kMaxParticles);
+                  glEndTransformFeedback();
+                  glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+                }});
+
+  _current = next;
+  _emit_start = (_emit_start + emit_count) % kMaxParticles;
+  _frame++;
+}
@@ -0,0 +1,82 @@
+#ifndef SOURCE_GRAPHICS_ENGINE_PARTICLE_SYSTEM_HPP_
+#define SOURCE_GRAPHICS_ENGINE_PARTICLE_SYSTEM_HPP_
+
+#include <QElapsedTimer>
+#include <QMatrix4x4>
+#include <QOpenGLExtraFunctions>
+#include <QOpenGLShaderProgram>
+#include <QStringList>
+#include <QVector4D>
+#include <array>
+#include <vector>
+
+#include "asset_loader.hpp"
+#include "render_queue.hpp"
+
+// Bursts of small piece sprites where tiles were deleted. Particles live in a
+// pair of buffers on the GPU, each frame a single point draw steps them from
+// one buffer into the other with transform feedback and draws them. The CPU
+// only uploads the burst positions, particles are spawned by the shader into
+// a ring of kMaxParticles slots, so the oldest are replaced first.
+class ParticleSystem : protected QOpenGLExtraFunctions {
+ public:
+  ParticleSystem();
+  ~ParticleSystem();
+
+  static QStringList ShaderPaths();
+  // the program is shared by all systems, see BoardResources
+  static void BuildProgram(QOpenGLShaderProgram &program, AssetLoader &assets);
+  void Init(QOpenGLShaderProgram *program);
+
+  // burst at board position x, y using atlas cell z, bursts beyond
+  // kMaxEmitters per frame are dropped
+  void Emit(const QVector4D &emitter);
+  // transform is the board transform of the view, texture the piece atlas
+  void Render(const QMatrix4x4 &transform, GLuint texture, int view,
+              RenderQueue &queue);
+
+  static constexpr int kMaxEmitters = 256;
+
+ private:
+  static constexpr int kMaxParticles = 16384;
+  static constexpr int kParticlesPerEmitter = 12;
+  // position and velocity in board space, remaining life and atlas cell
+  static constexpr int kParticleFloats = 6;
+  // longest particle life in seconds, see particles_vs.glsl
+  static constexpr float kMaxLife = 1.2f;
+  static constexpr float kMaxTimeStep = 0.1f;
+  // sprite size in tiles
+  static constexpr float kParticleSize = 0.3f;
+  // after the RenderQueue blocks
+  static constexpr GLuint kEmitterBinding = 2;
+
+  // uniforms of one step, kept in the RenderQueue frame data until drawn
+  typedef struct {
+    QMatrix4x4 transform;
+    float time_step;
+    int emit_start;
+    int emit_count;
+    int seed;
+  } StepParameters;
+
+  std::array<GLuint, 2> _vaos;
+  std::array<GLuint, 2> _buffers;
+  // buffer holding the current particles, the other one receives the next
+  int _current;
+  GLuint _emitter_ubo;
+  std::vector<QVector4D> _emitters;
+  // first slot of the ring the next burst is spawned into
+  int _emit_start;
+  int _frame;
+  QElapsedTimer _clock;
+  // seconds since the last burst, nothing is alive after kMaxLife
+  float _idle_time;
+  QOpenGLShaderProgram *_program;
+  int _time_step_location;
+  int _emit_start_location;
+  int _emit_count_location;
+  int _seed_location;
+  int _point_size_location;
+};
+
+#endif  // SOURCE_GRAPHICS_ENGINE_PARTICLE_SYSTEM_HPP_
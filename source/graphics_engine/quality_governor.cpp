@@ -0,0 +1,81 @@
+#include "quality_governor.hpp"
+
+#include <algorithm>
+
+constexpr std::array<QualityGovernor::Settings, QualityGovernor::kLevelCount>
+    QualityGovernor::kLevels;
+
+QualityGovernor::QualityGovernor(float frame_budget_ms)
+    : _frame_budget_ms(frame_budget_ms),
+      _level(0),
+      _override(false),
+      _window_frames(0),
+      _window_work_ms(0.0f),
+      _window_dropped_frames(0),
+      _calm_windows(0),
+      _required_calm_windows(kMinCalmWindows),
+      _just_returned(false) {}
+
+void QualityGovernor::SetOverride(int level) {
+  _override = level != kAuto;
+  if (_override) {
+    _level = std::clamp(level, 0, kLevelCount - 1);
+  }
+}
+
+bool QualityGovernor::AddFrame(float interval_ms, float work_ms) {
+  if (_override) {
+    return false;
+  }
+
+  _window_frames++;
+  _window_work_ms += work_ms;
+  if (interval_ms > _frame_budget_ms * kDroppedFrameInterval) {
+    _window_dropped_frames++;
+  }
+  if (_window_frames < kWindowFrames) {
+    return false;
+  }
+
+  float load = _window_work_ms / (_window_frames * _frame_budget_ms);
+  int dropped_frames = _window_dropped_frames;
+  _window_frames = 0;
+  _window_work_ms = 0.0f;
+  _window_dropped_frames = 0;
+
+  if (load > kDropLoad || dropped_frames > kMaxDroppedFrames) {
+    _calm_windows = 0;
+    if (_just_returned) {
+      // the better level did not hold, wait longer before trying it again
+      _required_calm_windows =
+          std::min(_required_calm_windows * 2, kMaxCalmWindows);
+    }
+    _just_returned = false;
+    return SetLevel(_level + 1);
+  }
+
+  if (load < kReturnLoad && dropped_frames == 0) {
+    _calm_windows++;
+    if (_calm_windows >= kMinCalmWindows) {
+      // the level held, a later drop is not caused by returning to it
+      _just_returned = false;
+    }
+  } else {
+    _calm_windows = 0;
+  }
+  if (_calm_windows >= _required_calm_windows && _level > 0) {
+    _calm_windows = 0;
+    _just_returned = true;
+    return SetLevel(_level - 1);
+  }
+  return false;
+}
+
+bool QualityGovernor::SetLevel(int level) {
+  level = std::clamp(level, 0, kLevelCount - 1);
+  if (level == _level) {
+    return false;
+  }
+  _level = level;
+  return true;
+}
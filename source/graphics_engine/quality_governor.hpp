@@ -0,0 +1,64 @@
+#ifndef SOURCE_GRAPHICS_ENGINE_QUALITY_GOVERNOR_HPP_
+#define SOURCE_GRAPHICS_ENGINE_QUALITY_GOVERNOR_HPP_
+
+#include <array>
+
+// Picks render settings that keep frames within the frame budget. Frame
+// times are judged per window of frames, quality drops after one bad window
+// but only returns after several calm ones, and returns more reluctantly each
+// time it had to drop again right after returning.
+class QualityGovernor {
+ public:
+  typedef struct {
+    // size of the rendered frame relative to the window
+    float render_scale;
+    // shade the background by the score
+    bool score_effect;
+    // the title animation advances every this many ticks
+    int title_tick_interval;
+  } Settings;
+
+  static constexpr int kAuto = -1;
+  static constexpr int kLevelCount = 4;
+
+  explicit QualityGovernor(float frame_budget_ms);
+
+  // fixes the quality level, 0 is the best, kAuto lets the governor decide
+  void SetOverride(int level);
+  // Takes the time since the previous frame and the time spent on this one,
+  // returns true when the settings changed.
+  bool AddFrame(float interval_ms, float work_ms);
+
+  int level() const { return _level; }
+  const Settings &settings() const { return kLevels[_level]; }
+
+ private:
+  static constexpr std::array<Settings, kLevelCount> kLevels = {{
+      {1.0f, true, 1},
+      {1.0f, false, 2},
+      {0.75f, false, 2},
+      {0.5f, false, 4},
+  }};
+  static constexpr int kWindowFrames = 30;
+  // fractions of the frame budget
+  static constexpr float kDropLoad = 0.9f;
+  static constexpr float kReturnLoad = 0.5f;
+  static constexpr float kDroppedFrameInterval = 1.5f;
+  static constexpr int kMaxDroppedFrames = kWindowFrames / 4;
+  static constexpr int kMinCalmWindows = 4;
+  static constexpr int kMaxCalmWindows = 64;
+
+  bool SetLevel(int level);
+
+  float _frame_budget_ms;
+  int _level;
+  bool _override;
+  int _window_frames;
+  float _window_work_ms;
+  int _window_dropped_frames;
+  int _calm_windows;
+  int _required_calm_windows;
+  bool _just_returned;
+};
+
+#endif  // SOURCE_GRAPHICS_ENGINE_QUALITY_GOVERNOR_HPP_
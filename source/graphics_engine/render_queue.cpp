@@ -0,0 +1,217 @@
+#include "render_queue.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+#include <numeric>
+#include <tuple>
+
+RenderQueue::RenderQueue()
+    : _frame_uniforms(),
+      _view_uniforms(),
+      _view_clips(),
+      _uniforms_dirty(true),
+      _frame_ubo(0),
+      _view_ubo(0),
+      _view_stride(sizeof(ViewUniforms)) {}
+
+RenderQueue::~RenderQueue() {}
+
+void RenderQueue::Init() {
+  initializeOpenGLFunctions();
+
+  // every view starts at a multiple of the offset alignment, so a draw can
+  // select its view with glBindBufferRange
+  GLint alignment = 1;
+  glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+  _view_stride = (sizeof(ViewUniforms) + alignment - 1) / alignment * alignment;
+
+  glGenBuffers(1, &_frame_ubo);
+  glBindBuffer(GL_UNIFORM_BUFFER, _frame_ubo);
+  glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), nullptr,
+               GL_DYNAMIC_DRAW);
+  glGenBuffers(1, &_view_ubo);
+  glBindBuffer(GL_UNIFORM_BUFFER, _view_ubo);
+  glBufferData(GL_UNIFORM_BUFFER, _view_stride * kMaxViews, nullptr,
+               GL_DYNAMIC_DRAW);
+  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+  glBindBufferBase(GL_UNIFORM_BUFFER, kFrameBinding, _frame_ubo);
+  glBindBufferRange(GL_UNIFORM_BUFFER, kViewBinding, _view_ubo, 0,
+                    sizeof(ViewUniforms));
+  _uniforms_dirty = true;
+}
+
+void RenderQueue::AttachProgram(QOpenGLShaderProgram &program) {
+  GLuint program_id = program.programId();
+  GLuint frame_index = glGetUniformBlockIndex(program_id, "FrameUniforms");
+  if (frame_index != GL_INVALID_INDEX) {
+    glUniformBlockBinding(program_id, frame_index, kFrameBinding);
+  }
+  GLuint view_index = glGetUniformBlockIndex(program_id, "ViewUniforms");
+  if (view_index != GL_INVALID_INDEX) {
+    glUniformBlockBinding(program_id, view_index, kViewBinding);
+  }
+}
+
+void RenderQueue::SetProjection(const QMatrix4x4 &projection) {
+  std::memcpy(_frame_uniforms.projection, projection.constData(),
+              sizeof(_frame_uniforms.projection));
+  _uniforms_dirty = true;
+}
+
+void RenderQueue::SetScore(bool score_mode, float score) {
+  if (_frame_uniforms.score_mode != score_mode ||
+      _frame_uniforms.score != score) {
+    _frame_uniforms.score_mode = score_mode;
+    _frame_uniforms.score = score;
+    _uniforms_dirty = true;
+  }
+}
+
+void RenderQueue::SetView(int view, const QMatrix4x4 &board_transform,
+                          const QRectF &clip) {
+  _view_clips[view] = clip;
+  GLfloat *data = _view_uniforms[view].board_transform;
+  if (std::memcmp(data, board_transform.constData(),
+                  sizeof(ViewUniforms::board_transform)) != 0) {
+    std::memcpy(data, board_transform.constData(),
+                sizeof(ViewUniforms::board_transform));
+    _uniforms_dirty = true;
+  }
+}
+
+void RenderQueue::Submit(DrawCommand command) {
+  _commands.push_back(std::move(command));
+}
+
+void RenderQueue::Flush() {
+  if (_commands.empty()) {
+    return;
+  }
+  UploadUniforms();
+
+  // Sorted by index, ties keep the order of submission. Same order as a
+  // stable sort, without its temporary buffer.
+  _order.resize(_commands.size());
+  std::iota(_order.begin(), _order.end(), 0);
+  std::sort(_order.begin(), _order.end(), [this](int a, int b) {
+    const DrawCommand &first = _commands[a];
+    const DrawCommand &second = _commands[b];
+    return std::tie(first.pass, first.program, first.textures, first.view,
+                    first.vao, a) < std::tie(second.pass, second.program,
+                                             second.textures, second.view,
+                                             second.vao, b);
+  });
+
+  // clip rectangles are relative to the viewport of the target
+  GLint viewport[4];
+  glGetIntegerv(GL_VIEWPORT, viewport);
+
+  QOpenGLShaderProgram *bound_program = nullptr;
+  std::array<GLuint, 2> bound_textures = {{0, 0}};
+  GLuint bound_vao = 0;
+  // the block range stays bound when switching to kNoView
+  int bound_view = 0;
+  int current_view = kNoView;
+  bool scissor = false;
+  for (int index : _order) {
+    const DrawCommand &command = _commands[index];
+    if (command.program != bound_program) {
+      command.program->bind();
+      bound_program = command.program;
+    }
+    for (int unit = 0; unit < static_cast<int>(bound_textures.size());
+         unit++) {
+      if (command.textures[unit] != bound_textures[unit]) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(GL_TEXTURE_2D, command.textures[unit]);
+        bound_textures[unit] = command.textures[unit];
+      }
+    }
+    if (command.view != current_view) {
+      current_view = command.view;
+      if (current_view != kNoView && current_view != bound_view) {
+        glBindBufferRange(GL_UNIFORM_BUFFER, kViewBinding, _view_ubo,
+                          current_view * _view_stride, sizeof(ViewUniforms));
+        bound_view = current_view;
+      }
+      bool clipped =
+          current_view != kNoView && !_view_clips[current_view].isNull();
+      if (clipped) {
+        ApplyClip(current_view, viewport);
+      }
+      if (clipped && !scissor) {
+        glEnable(GL_SCISSOR_TEST);
+      } else if (!clipped && scissor) {
+        glDisable(GL_SCISSOR_TEST);
+      }
+      scissor = clipped;
+    }
+    if (command.vao != bound_vao) {
+      glBindVertexArray(command.vao);
+      bound_vao = command.vao;
+    }
+    if (command.set_uniforms) {
+      command.set_uniforms();
+    }
+
+    if (command.draw) {
+      command.draw();
+    } else if (command.instance_count > 0) {
+      glDrawArraysInstanced(GL_TRIANGLES, 0, command.vertex_count,
+                            command.instance_count);
+    } else {
+      glDrawArrays(GL_TRIANGLES, 0, command.vertex_count);
+    }
+  }
+  _commands.clear();
+  _frame_arena.Reset();
+
+  // leave the default state behind for code drawing outside the queue
+  glBindVertexArray(0);
+  for (int unit = static_cast<int>(bound_textures.size()) - 1; unit >= 0;
+       unit--) {
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(GL_TEXTURE_2D, 0);
+  }
+  if (bound_view != 0) {
+    glBindBufferRange(GL_UNIFORM_BUFFER, kViewBinding, _view_ubo, 0,
+                      sizeof(ViewUniforms));
+  }
+  if (scissor) {
+    glDisable(GL_SCISSOR_TEST);
+  }
+  bound_program->release();
+}
+
+void RenderQueue::ApplyClip(int view, const GLint *viewport) {
+  // normalized device coordinates to pixels, y points up in both, so the
+  // smaller y of the rect, its top, is the bottom edge
+  const QRectF &clip = _view_clips[view];
+  GLint left = viewport[0] + std::lround((clip.left() + 1.0) / 2.0 *
+                                         viewport[2]);
+  GLint right = viewport[0] + std::lround((clip.right() + 1.0) / 2.0 *
+                                          viewport[2]);
+  GLint bottom = viewport[1] + std::lround((clip.top() + 1.0) / 2.0 *
+                                           viewport[3]);
+  GLint top = viewport[1] + std::lround((clip.bottom() + 1.0) / 2.0 *
+                                        viewport[3]);
+  glScissor(left, bottom, right - left, top - bottom);
+}
+
+void RenderQueue::UploadUniforms() {
+  if (!_uniforms_dirty) {
+    return;
+  }
+  glBindBuffer(GL_UNIFORM_BUFFER, _frame_ubo);
+  glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameUniforms),
+                  &_frame_uniforms);
+  glBindBuffer(GL_UNIFORM_BUFFER, _view_ubo);
+  for (int view = 0; view < kMaxViews; view++) {
+    glBufferSubData(GL_UNIFORM_BUFFER, view * _view_stride,
+                    sizeof(ViewUniforms), &_view_uniforms[view]);
+  }
+  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+  _uniforms_dirty = false;
+}
@@ -0,0 +1,111 @@
+#ifndef SOURCE_GRAPHICS_ENGINE_RENDER_QUEUE_HPP_
+#define SOURCE_GRAPHICS_ENGINE_RENDER_QUEUE_HPP_
+
+#include <QMatrix4x4>
+#include <QOpenGLExtraFunctions>
+#include <QOpenGLShaderProgram>
+#include <QRectF>
+#include <array>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+#include "game_logic/frame_arena.hpp"
+
+// Collects draws and submits them sorted by program, textures and vertex
+// array, skipping redundant state changes. Per frame data lives in the
+// FrameUniforms block and per view data, the board transform, in the
+// ViewUniforms block, both shared by all programs. A view can be clipped to
+// a rectangle of the target, so several boards can share one Flush.
+class RenderQueue : protected QOpenGLExtraFunctions {
+ public:
+  // Draws of a lower pass are submitted first, draws within a pass may be
+  // reordered and must not depend on each other.
+  enum Pass { kOpaque = 0, kTiles, kMovingTiles, kParticles, kOverlay };
+
+  typedef struct {
+    Pass pass;
+    QOpenGLShaderProgram *program;
+    // bound to texture units 0 and 1, 0 binds nothing
+    std::array<GLuint, 2> textures;
+    GLuint vao;
+    // kNoView for draws that do not use the ViewUniforms block
+    int view;
+    GLsizei vertex_count;
+    // 0 draws without instancing
+    GLsizei instance_count;
+    // sets per draw uniforms, may be empty
+    std::function<void()> set_uniforms;
+    // issues the draw instead of the default triangles, may be empty
+    std::function<void()> draw;
+  } DrawCommand;
+
+  static constexpr int kMaxViews = 16;
+  static constexpr int kNoView = -1;
+
+  RenderQueue();
+  ~RenderQueue();
+
+  void Init();
+  // binds the uniform blocks of a linked program to the shared buffers
+  void AttachProgram(QOpenGLShaderProgram &program);
+
+  // uniform data applies to every draw of the next Flush
+  void SetProjection(const QMatrix4x4 &projection);
+  void SetScore(bool score_mode, float score);
+  // clip is in normalized device coordinates, a null rect does not clip
+  void SetView(int view, const QMatrix4x4 &board_transform,
+               const QRectF &clip = QRectF());
+
+  // Copies value into memory that lives until the next Flush. Callbacks
+  // capture a pointer to it instead of the value, small captures are stored
+  // by std::function without allocating.
+  template <typename T>
+  const T *FrameData(const T &value);
+
+  void Submit(DrawCommand command);
+  void Flush();
+
+ private:
+  // std140 layouts of the uniform blocks
+  typedef struct {
+    GLfloat projection[16];
+    GLfloat score;
+    GLint score_mode;
+    GLfloat padding[2];
+  } FrameUniforms;
+
+  typedef struct {
+    GLfloat board_transform[16];
+  } ViewUniforms;
+
+  static constexpr GLuint kFrameBinding = 0;
+  static constexpr GLuint kViewBinding = 1;
+
+  void UploadUniforms();
+  void ApplyClip(int view, const GLint *viewport);
+
+  std::vector<DrawCommand> _commands;
+  // draw order as indices into _commands
+  std::vector<int> _order;
+  FrameArena _frame_arena;
+  FrameUniforms _frame_uniforms;
+  std::array<ViewUniforms, kMaxViews> _view_uniforms;
+  std::array<QRectF, kMaxViews> _view_clips;
+  bool _uniforms_dirty;
+  GLuint _frame_ubo;
+  GLuint _view_ubo;
+  GLint _view_stride;
+};
+
+template <typename T>
+const T *RenderQueue::FrameData(const T &value) {
+  // the arena is reset without running destructors
+  static_assert(std::is_trivially_destructible<T>::value,
+                "frame data must be trivially destructible");
+  void *memory = _frame_arena.resource()->allocate(sizeof(T), alignof(T));
+  return new (memory) T(value);
+}
+
+#endif  // SOURCE_GRAPHICS_ENGINE_RENDER_QUEUE_HPP_
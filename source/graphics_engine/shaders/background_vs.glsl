@@ -1,9 +1,11 @@
 in vec2 position;
 in vec2 tex;
 
-uniform int score_mode;
-uniform float score;
-uniform mat4 transform;
+layout(std140) uniform FrameUniforms {
+    mat4 u_projection;
+    float u_score;
+    int u_score_mode;
+};
 
 flat out int vtf_score_mode;
 flat out float vtf_score;
@@ -11,8 +13,8 @@ out vec2 vtf_texcoord;
 
 void main()
 {
-    gl_Position = transform * vec4(position, 0.0, 1.0);
+    gl_Position = u_projection * vec4(position, 0.0, 1.0);
     vtf_texcoord = tex;
-    vtf_score_mode = score_mode;
-    vtf_score = score;
+    vtf_score_mode = u_score_mode;
+    vtf_score = u_score;
 }
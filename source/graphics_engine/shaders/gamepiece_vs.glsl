@@ -1,16 +1,29 @@
+// unit tile quad
 in vec2 position;
-in vec3 offset;
-in vec2 tex;
+// packed board tile, fixed point offsets and type | animation << 4
+in ivec2 tile_offset;
+in uint tile_state;
 
-uniform int is_gold;
-uniform mat4 transform;
+layout(std140) uniform ViewUniforms {
+    mat4 u_board_transform;
+};
+// chunk origin in tiles, and chunk height to place the instances
+uniform ivec3 u_chunk;
+uniform int u_atlas_cells[4];
+uniform float u_offset_scale;
 
 flat out int vtf_is_gold;
 out vec2 vtf_texcoord;
 
 void main()
 {
-    gl_Position = transform * vec4(position + offset.xy, offset.z, 1.0);
-    vtf_texcoord = tex;
-    vtf_is_gold = is_gold;
+    ivec2 tile = u_chunk.xy + ivec2(gl_InstanceID / u_chunk.z,
+                                    gl_InstanceID % u_chunk.z);
+    vec2 offset = vec2(tile_offset) * u_offset_scale;
+    int atlas_cell = u_atlas_cells[int(tile_state & 15u)];
+    vec2 board_pos = vec2(tile) + offset + position;
+    gl_Position = u_board_transform * vec4(board_pos, 0.0, 1.0);
+    vtf_texcoord = vec2((float(atlas_cell) + position.x) / 4.0,
+                        1.0 - position.y);
+    vtf_is_gold = 0;
 }
@@ -0,0 +1,17 @@
+in vec2 position;
+// board position including offset, and atlas cell
+in vec3 instance;
+
+layout(std140) uniform ViewUniforms {
+    mat4 u_board_transform;
+};
+
+flat out int vtf_is_gold;
+out vec2 vtf_texcoord;
+
+void main()
+{
+    gl_Position = u_board_transform * vec4(instance.xy + position, 0.0, 1.0);
+    vtf_texcoord = vec2((instance.z + position.x) / 4.0, 1.0 - position.y);
+    vtf_is_gold = 0;
+}
@@ -0,0 +1,17 @@
+#ifdef GL_ES
+    precision mediump int;
+    precision mediump float;
+#endif
+
+uniform sampler2D u_tex_pieces;
+in float vtf_alpha;
+flat in float vtf_cell;
+
+out highp vec4 frag_color;
+
+void main()
+{
+    vec2 texcoord = vec2((vtf_cell + gl_PointCoord.x) / 4.0, gl_PointCoord.y);
+    vec4 tex_sample = texture(u_tex_pieces, texcoord);
+    frag_color = vec4(tex_sample.rgb, tex_sample.a * vtf_alpha);
+}
@@ -0,0 +1,75 @@
+// position and velocity in board space
+in vec4 motion;
+// remaining life in seconds, and atlas cell
+in vec2 life_cell;
+
+layout(std140) uniform ViewUniforms {
+    mat4 u_board_transform;
+};
+
+// board position and atlas cell per burst
+layout(std140) uniform ParticleEmitters {
+    vec4 u_emitters[256];
+};
+
+uniform float u_time_step;
+uniform int u_max_particles;
+uniform int u_particles_per_emitter;
+// this frame's bursts spawn into the ring slots from u_emit_start on
+uniform int u_emit_start;
+uniform int u_emit_count;
+uniform int u_seed;
+uniform float u_point_size;
+
+// captured by transform feedback as the next state
+out vec4 tf_motion;
+out vec2 tf_life_cell;
+
+out float vtf_alpha;
+flat out float vtf_cell;
+
+const float kGravity = 12.0;
+const float kFadeTime = 0.4;
+
+float Random(int index, int channel) {
+    uint n = uint(index) * 4u + uint(channel) + uint(u_seed) * 1664525u;
+    n = (n << 13u) ^ n;
+    n = n * (n * n * 15731u + 789221u) + 1376312589u;
+    return float(n & 0x7fffffffu) / 2147483647.0;
+}
+
+void main()
+{
+    vec4 next_motion = motion;
+    vec2 next_life_cell = life_cell;
+
+    int slot = (gl_VertexID - u_emit_start + u_max_particles) % u_max_particles;
+    if (slot < u_emit_count) {
+        vec4 emitter = u_emitters[slot / u_particles_per_emitter];
+        float angle = Random(gl_VertexID, 0) * 6.2831853;
+        float speed = mix(1.5, 5.0, Random(gl_VertexID, 1));
+        next_motion.xy = emitter.xy + vec2(Random(gl_VertexID, 2),
+                                           Random(gl_VertexID, 3));
+        next_motion.zw = vec2(cos(angle), sin(angle) + 1.0) * speed;
+        next_life_cell = vec2(mix(0.6, 1.2, Random(gl_VertexID, 4)),
+                              emitter.z);
+    } else if (life_cell.x > 0.0) {
+        next_motion.w -= kGravity * u_time_step;
+        next_motion.xy += next_motion.zw * u_time_step;
+        next_life_cell.x -= u_time_step;
+    }
+
+    tf_motion = next_motion;
+    tf_life_cell = next_life_cell;
+
+    vtf_alpha = clamp(next_life_cell.x / kFadeTime, 0.0, 1.0);
+    vtf_cell = next_life_cell.y;
+    if (next_life_cell.x > 0.0) {
+        gl_Position = u_board_transform * vec4(next_motion.xy, 0.0, 1.0);
+        gl_PointSize = u_point_size;
+    } else {
+        // dead particles are clipped
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+        gl_PointSize = 1.0;
+    }
+}
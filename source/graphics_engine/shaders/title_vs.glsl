@@ -1,10 +1,15 @@
 in vec2 pos;
 in vec2 tex;
-uniform mat4 transform;
+layout(std140) uniform FrameUniforms {
+    mat4 u_projection;
+    float u_score;
+    int u_score_mode;
+};
+uniform mat4 model;
 
 out vec2 vtf_texcoord;
 
 void main() {
-    gl_Position = transform * vec4(pos, 0.0, 1.0);
+    gl_Position = u_projection * model * vec4(pos, 0.0, 1.0);
     vtf_texcoord = tex;
 }
@@ -0,0 +1,24 @@
+#ifdef GL_ES
+    precision mediump int;
+    precision mediump float;
+#endif
+
+uniform sampler2D u_tex_pieces;
+// atlas cell per tile, one row per board column, 255 for an empty tile
+uniform highp usampler2D u_type_map;
+in highp vec2 vtf_board_pos;
+
+out highp vec4 frag_color;
+
+void main()
+{
+    highp ivec2 tile = ivec2(floor(vtf_board_pos));
+    uint atlas_cell = texelFetch(u_type_map, tile.yx, 0).r;
+    if (atlas_cell == 255u) {
+        discard;
+    }
+    highp vec2 tile_pos = fract(vtf_board_pos);
+    vec2 texcoord = vec2((float(atlas_cell) + tile_pos.x) / 4.0, 1.0 - tile_pos.y);
+    // explicit lod, derivatives are undefined after the discard
+    frag_color = textureLod(u_tex_pieces, texcoord, 0.0);
+}
@@ -0,0 +1,13 @@
+in vec2 position;
+
+layout(std140) uniform ViewUniforms {
+    mat4 u_board_transform;
+};
+
+out highp vec2 vtf_board_pos;
+
+void main()
+{
+    gl_Position = u_board_transform * vec4(position, 0.0, 1.0);
+    vtf_board_pos = position;
+}
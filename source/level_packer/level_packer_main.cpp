@@ -0,0 +1,168 @@
+// Packs levels into a LevelPack for tux_match --levels. Curated levels are
+// read from text files, generated levels continue after them.
+//   tux_match_level_packer --output levels.pack --input curated.txt
+//       --generate 20 --seed 42
+// A text level starts with a line "level <width> <height> <goal> <seed>",
+// followed by height rows of width piece types from 0 to 3, the top row
+// first. Empty lines and lines starting with # are skipped.
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "game_logic/game_board.hpp"
+#include "game_logic/game_logic.hpp"
+#include "game_logic/level_pack.hpp"
+#include "game_logic/random_source.hpp"
+#include "game_logic/worker_pool.hpp"
+
+namespace {
+
+// like GameLogic, the first level and how levels grow
+constexpr int kFirstSize = 9;
+constexpr int kLevelGrowth = 3;
+
+typedef struct {
+  int width;
+  int height;
+  int goal;
+  uint64_t seed;
+  // column major
+  std::vector<uint8_t> types;
+} Level;
+
+bool NextLine(std::istream &input, std::string *line, int *line_number) {
+  while (std::getline(input, *line)) {
+    ++*line_number;
+    if (!line->empty() && (*line)[0] != '#') {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool ReadLevels(const std::string &path, std::vector<Level> *levels) {
+  std::ifstream input(path);
+  if (!input) {
+    std::cerr << "could not open " << path << std::endl;
+    return false;
+  }
+  std::string line;
+  int line_number = 0;
+  while (NextLine(input, &line, &line_number)) {
+    Level level;
+    std::istringstream header(line);
+    std::string keyword;
+    header >> keyword >> level.width >> level.height >> level.goal >>
+        level.seed;
+    if (!header || keyword != "level" || level.width <= 0 ||
+        level.width > LevelPack::kMaxSize || level.height <= 0 ||
+        level.height > LevelPack::kMaxSize || level.goal <= 0) {
+      std::cerr << path << ":" << line_number
+                << ": expected level <width> <height> <goal> <seed>"
+                << std::endl;
+      return false;
+    }
+    level.types.resize(level.width * level.height);
+    for (int y = level.height - 1; y >= 0; y--) {
+      bool valid = NextLine(input, &line, &line_number) &&
+                   static_cast<int>(line.size()) == level.width;
+      for (int x = 0; valid && x < level.width; x++) {
+        valid = line[x] >= '0' && line[x] <= '3';
+        level.types[x * level.height + y] = line[x] - '0';
+      }
+      if (!valid) {
+        std::cerr << path << ":" << line_number << ": expected "
+                  << level.width << " piece types from 0 to 3" << std::endl;
+        return false;
+      }
+    }
+    levels->push_back(std::move(level));
+  }
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  std::string output;
+  std::vector<std::string> inputs;
+  int generate_count = 0;
+  uint64_t seed = RandomSource::kDefaultSeed;
+  for (int i = 1; i < argc; i += 2) {
+    if (i + 1 < argc && std::strcmp(argv[i], "--output") == 0) {
+      output = argv[i + 1];
+    } else if (i + 1 < argc && std::strcmp(argv[i], "--input") == 0) {
+      inputs.push_back(argv[i + 1]);
+    } else if (i + 1 < argc && std::strcmp(argv[i], "--generate") == 0) {
+      generate_count = std::atoi(argv[i + 1]);
+    } else if (i + 1 < argc && std::strcmp(argv[i], "--seed") == 0) {
+      seed = std::strtoull(argv[i + 1], nullptr, 0);
+    } else {
+      output.clear();
+      break;
+    }
+  }
+  if (output.empty()) {
+    std::cerr << "usage: " << argv[0]
+              << " --output path [--input path]... [--generate count]"
+                 " [--seed seed]"
+              << std::endl;
+    return 1;
+  }
+
+  std::vector<Level> levels;
+  for (const std::string &input : inputs) {
+    if (!ReadLevels(input, &levels)) {
+      return 1;
+    }
+  }
+
+  // generated levels grow from the last curated one and get goals
+  // calibrated like in the game
+  RandomSource random(seed);
+  size_t curated_count = levels.size();
+  std::vector<std::future<Level>> generated;
+  for (int i = 0; i < generate_count; i++) {
+    Level level = {kFirstSize, kFirstSize, 0, 0, {}};
+    if (!levels.empty()) {
+      const Level &previous = levels.back();
+      level.width = previous.width + kLevelGrowth;
+      level.height = previous.height + kLevelGrowth;
+    }
+    level.seed = random.Next();
+    level.seed = level.seed << 32 | random.Next();
+    GoalCalibrator::Options options =
+        GameLogic::GoalOptions(static_cast<int>(levels.size()));
+    // big boards take a while, so they are generated side by side
+    generated.push_back(
+        WorkerPool::Global().Run([level, options]() mutable {
+          level.types =
+              GameBoard::GenerateTypes(level.width, level.height, level.seed);
+          level.goal = GameBoard::CalibrateGoal(
+              level.types, level.width, level.height, level.seed, options);
+          return level;
+        }));
+    levels.push_back(std::move(level));
+  }
+
+  LevelPackWriter writer;
+  for (size_t i = 0; i < levels.size(); i++) {
+    if (i >= curated_count) {
+      levels[i] = generated[i - curated_count].get();
+    }
+    writer.AddLevel(levels[i].width, levels[i].height, levels[i].goal,
+                    levels[i].seed, levels[i].types);
+  }
+  if (!writer.Write(output)) {
+    return 1;
+  }
+  std::cout << "packed " << writer.level_count() << " levels into " << output
+            << std::endl;
+  return 0;
+}
@@ -17,8 +17,31 @@ int main(int argc, char *argv[]) {
   parser.setApplicationDescription("Tux Match!");
   QCommandLineOption force_gles_option("force-gles", "force usage of openGLES");
   parser.addOption(force_gles_option);
+  QCommandLineOption input_prediction_option(
+      "input-prediction", "extrapolate dragging <ms> ahead, 0 disables",
+      "ms", "0");
+  parser.addOption(input_prediction_option);
+  QCommandLineOption seed_option("seed", "seed for reproducible boards",
+                                 "seed");
+  parser.addOption(seed_option);
+  QCommandLineOption quality_option(
+      "quality", "render quality, auto or 0 (best) to 3 (fastest)", "level",
+      "auto");
+  parser.addOption(quality_option);
+  QCommandLineOption boards_option(
+      "boards", "play <count> boards side by side, up to 16", "count", "1");
+  parser.addOption(boards_option);
+  QCommandLineOption publish_option(
+      "publish", "publish the board state to shared memory <name>, like /tux",
+      "name");
+  parser.addOption(publish_option);
+  QCommandLineOption levels_option(
+      "levels", "play the levels of a pack made by tux_match_level_packer",
+      "path");
+  parser.addOption(levels_option);
   parser.process(app);
   bool force_gles = parser.isSet(force_gles_option);
+  float input_prediction = parser.value(input_prediction_option).toFloat();
 
   // set GL version
   QSurfaceFormat glFormat;
@@ -36,9 +59,25 @@ int main(int argc, char *argv[]) {
   QSurfaceFormat::setDefaultFormat(glFormat);
 
   // Create the main app window
-  GraphicsEngine window;
+  GraphicsEngine window(parser.value(boards_option).toInt());
 
   window.setTitle("Tux Match!");
+  window.SetInputPrediction(input_prediction);
+  if (parser.isSet(seed_option)) {
+    window.SetSeed(parser.value(seed_option).toULongLong());
+  }
+  QString quality = parser.value(quality_option);
+  if (quality != "auto") {
+    window.SetQuality(quality.toInt());
+  }
+  if (parser.isSet(levels_option) &&
+      !window.LoadLevelPack(parser.value(levels_option))) {
+    return 1;
+  }
+  if (parser.isSet(publish_option) &&
+      !window.PublishState(parser.value(publish_option))) {
+    return 1;
+  }
   QSize available_size = QDesktopWidget().availableGeometry().size() * 0.7;
   int min_dimension = std::min(available_size.width(), available_size.height());
   window.resize(min_dimension, min_dimension);
@@ -0,0 +1,78 @@
+// Follows a game published with --publish from another process, and prints
+// its state whenever it changed.
+//   tux_match_observer --name /tux_match --interval 100
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "game_logic/game_board.hpp"
+#include "game_logic/state_publisher.hpp"
+
+namespace {
+
+typedef struct {
+  uint64_t board_version;
+  int score;
+  int goal;
+  int state;
+  int width;
+  int height;
+  // tiles per piece type
+  std::array<int, GameBoard::kNone + 1> counts;
+} Summary;
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  std::string name = "/tux_match";
+  int interval_ms = 100;
+  for (int i = 1; i < argc; i += 2) {
+    if (i + 1 < argc && std::strcmp(argv[i], "--name") == 0) {
+      name = argv[i + 1];
+    } else if (i + 1 < argc && std::strcmp(argv[i], "--interval") == 0) {
+      interval_ms = std::max(1, std::atoi(argv[i + 1]));
+    } else {
+      std::cerr << "usage: " << argv[0] << " [--name name] [--interval ms]"
+                << std::endl;
+      return 1;
+    }
+  }
+
+  StateReader reader;
+  if (!reader.Open(name)) {
+    return 1;
+  }
+  Summary last = {};
+  last.board_version = ~0ull;
+  while (true) {
+    Summary summary = {};
+    bool published = reader.Read([&summary](const StatePublisher::Slot &slot,
+                                            const uint8_t *types) {
+      // read again from scratch when the slot was overwritten meanwhile
+      summary = {slot.board_version, slot.score, slot.goal, slot.state,
+                 slot.width,         slot.height, {}};
+      for (int i = 0; i < slot.width * slot.height; i++) {
+        summary.counts[std::min<int>(types[i], GameBoard::kNone)]++;
+      }
+    });
+    bool changed = summary.board_version != last.board_version ||
+                   summary.score != last.score || summary.state != last.state;
+    if (published && changed) {
+      std::cout << "state " << summary.state << " score " << summary.score
+                << "/" << summary.goal << " board " << summary.width << "x"
+                << summary.height << " pieces";
+      for (int type = 0; type < GameBoard::kNone; type++) {
+        std::cout << " " << summary.counts[type];
+      }
+      std::cout << std::endl;
+      last = summary;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(interval_ms));
+  }
+  return 0;
+}
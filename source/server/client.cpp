@@ -0,0 +1,144 @@
+#include "client.hpp"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+Client::Client()
+    : _fd(-1),
+      _width(0),
+      _height(0),
+      _score(0),
+      _goal(0),
+      _state(0),
+      _move_score(0) {}
+
+Client::~Client() { Close(); }
+
+bool Client::Connect(const std::string &socket_path) {
+  sockaddr_un address = {};
+  address.sun_family = AF_UNIX;
+  if (socket_path.size() >= sizeof(address.sun_path)) {
+    return false;
+  }
+  std::strcpy(address.sun_path, socket_path.c_str());
+
+  _fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (_fd < 0 || connect(_fd, reinterpret_cast<sockaddr *>(&address),
+                         sizeof(address)) != 0) {
+    Close();
+    return false;
+  }
+  return true;
+}
+
+void Client::Close() {
+  if (_fd >= 0) {
+    Protocol::Writer writer(_output);
+    writer.Begin(Protocol::kBye);
+    writer.End();
+    Send();
+    close(_fd);
+    _fd = -1;
+  }
+}
+
+bool Client::Hello(uint64_t seed) {
+  Protocol::Writer writer(_output);
+  writer.Begin(Protocol::kHello);
+  writer.Put64(seed);
+  writer.End();
+  return Send() && Receive();
+}
+
+bool Client::Swap(int x, int y, Protocol::Direction direction) {
+  Protocol::Writer writer(_output);
+  writer.Begin(Protocol::kSwap);
+  writer.Put16(x);
+  writer.Put16(y);
+  writer.Put8(direction);
+  writer.End();
+  return Send() && Receive();
+}
+
+bool Client::Continue() {
+  Protocol::Writer writer(_output);
+  writer.Begin(Protocol::kContinue);
+  writer.End();
+  return Send() && Receive();
+}
+
+bool Client::Send() {
+  size_t offset = 0;
+  while (offset < _output.size()) {
+    ssize_t bytes = send(_fd, _output.data() + offset, _output.size() - offset,
+                         MSG_NOSIGNAL);
+    if (bytes < 0 && errno == EINTR) {
+      continue;
+    }
+    if (bytes <= 0) {
+      _output.clear();
+      return false;
+    }
+    offset += bytes;
+  }
+  _output.clear();
+  return true;
+}
+
+bool Client::Receive() {
+  Protocol::MessageType type;
+  Protocol::Reader payload(nullptr, 0);
+  long frame_size;
+  uint8_t buffer[4096];
+  while ((frame_size = Protocol::ParseFrame(_input.data(), _input.size(),
+                                            &type, &payload)) == 0) {
+    ssize_t bytes = recv(_fd, buffer, sizeof(buffer), 0);
+    if (bytes < 0 && errno == EINTR) {
+      continue;
+    }
+    if (bytes <= 0) {
+      return false;
+    }
+    _input.insert(_input.end(), buffer, buffer + bytes);
+  }
+  if (frame_size < 0) {
+    return false;
+  }
+
+  bool applied = false;
+  if (type == Protocol::kBoard) {
+    ReadStatus(payload);
+    _width = payload.Get16();
+    _height = payload.Get16();
+    const uint8_t *types = payload.GetBytes(_width * _height);
+    if (types) {
+      _types.assign(types, types + _width * _height);
+    }
+    _move_score = 0;
+    applied = payload.ok();
+  } else if (type == Protocol::kDelta) {
+    ReadStatus(payload);
+    _move_score = static_cast<int32_t>(payload.Get32());
+    uint32_t count = payload.Get32();
+    for (uint32_t change = 0; change < count && payload.ok(); change++) {
+      uint32_t index = payload.Get32();
+      uint8_t tile_type = payload.Get8();
+      if (index < _types.size()) {
+        _types[index] = tile_type;
+      }
+    }
+    applied = payload.ok();
+  }
+  _input.erase(_input.begin(), _input.begin() + frame_size);
+  return applied;
+}
+
+void Client::ReadStatus(Protocol::Reader &payload) {
+  _score = payload.Get32();
+  _goal = payload.Get32();
+  _state = payload.Get8();
+}
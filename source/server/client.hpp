@@ -0,0 +1,54 @@
+#ifndef SOURCE_SERVER_CLIENT_HPP_
+#define SOURCE_SERVER_CLIENT_HPP_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "protocol.hpp"
+
+// Blocking client for the game server, keeps a copy of the board that is
+// updated from every reply. Stands in for thin clients and drives the load
+// generator.
+class Client {
+ public:
+  Client();
+  ~Client();
+
+  bool Connect(const std::string &socket_path);
+  void Close();
+
+  // each returns false when the server did not answer as expected
+  bool Hello(uint64_t seed);
+  bool Swap(int x, int y, Protocol::Direction direction);
+  bool Continue();
+
+  int width() const { return _width; }
+  int height() const { return _height; }
+  int score() const { return _score; }
+  int goal() const { return _goal; }
+  // GameLogic::GameState
+  int state() const { return _state; }
+  // score of the last swap
+  int move_score() const { return _move_score; }
+  int type(int x, int y) const { return _types[x * _height + y]; }
+
+ private:
+  bool Send();
+  // reads the reply frame and applies it to the board
+  bool Receive();
+  void ReadStatus(Protocol::Reader &payload);
+
+  int _fd;
+  std::vector<uint8_t> _output;
+  std::vector<uint8_t> _input;
+  int _width;
+  int _height;
+  int _score;
+  int _goal;
+  int _state;
+  int _move_score;
+  std::vector<uint8_t> _types;
+};
+
+#endif  // SOURCE_SERVER_CLIENT_HPP_
@@ -0,0 +1,147 @@
+// Opens many concurrent sessions on a running server and plays random swaps
+// on all of them, then reports session setup and move rates and latencies.
+//   tux_match_load --socket /tmp/tux_match.sock --threads 4 --sessions 250
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "client.hpp"
+#include "game_logic/random_source.hpp"
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+typedef struct {
+  std::vector<double> setup_us;
+  std::vector<double> move_us;
+  int scoring_moves;
+  int failures;
+} ThreadResult;
+
+double Microseconds(Clock::duration duration) {
+  return std::chrono::duration<double, std::micro>(duration).count();
+}
+
+double Percentile(std::vector<double> &values, double fraction) {
+  if (values.empty()) {
+    return 0.0;
+  }
+  size_t index = std::min(values.size() - 1,
+                          static_cast<size_t>(fraction * values.size()));
+  std::nth_element(values.begin(), values.begin() + index, values.end());
+  return values[index];
+}
+
+void RunThread(const std::string &socket_path, int sessions, int moves,
+               uint64_t seed, ThreadResult *result) {
+  RandomSource random(seed);
+  std::vector<std::unique_ptr<Client>> clients;
+  // all sessions of the thread stay open together
+  for (int session = 0; session < sessions; session++) {
+    auto client = std::make_unique<Client>();
+    Clock::time_point start = Clock::now();
+    if (!client->Connect(socket_path) || !client->Hello(random.Next())) {
+      result->failures++;
+      continue;
+    }
+    result->setup_us.push_back(Microseconds(Clock::now() - start));
+    clients.push_back(std::move(client));
+  }
+
+  for (int move = 0; move < moves; move++) {
+    for (auto &client : clients) {
+      Clock::time_point start = Clock::now();
+      bool ok;
+      if (client->state() != 0) {
+        // level complete, continue to the next one
+        ok = client->Continue();
+      } else {
+        int x = random.Uniform(client->width());
+        int y = random.Uniform(client->height());
+        auto direction = static_cast<Protocol::Direction>(random.Uniform(4));
+        ok = client->Swap(x, y, direction);
+        result->scoring_moves += ok && client->move_score() > 0;
+      }
+      if (!ok) {
+        result->failures++;
+        continue;
+      }
+      result->move_us.push_back(Microseconds(Clock::now() - start));
+    }
+  }
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  std::string socket_path = "/tmp/tux_match.sock";
+  int thread_count = 4;
+  int sessions = 250;
+  int moves = 20;
+  for (int i = 1; i < argc; i += 2) {
+    if (i + 1 < argc && std::strcmp(argv[i], "--socket") == 0) {
+      socket_path = argv[i + 1];
+    } else if (i + 1 < argc && std::strcmp(argv[i], "--threads") == 0) {
+      thread_count = std::max(1, std::atoi(argv[i + 1]));
+    } else if (i + 1 < argc && std::strcmp(argv[i], "--sessions") == 0) {
+      sessions = std::max(1, std::atoi(argv[i + 1]));
+    } else if (i + 1 < argc && std::strcmp(argv[i], "--moves") == 0) {
+      moves = std::max(0, std::atoi(argv[i + 1]));
+    } else {
+      std::cerr << "usage: " << argv[0]
+                << " [--socket path] [--threads count]"
+                   " [--sessions per thread] [--moves per session]"
+                << std::endl;
+      return 1;
+    }
+  }
+
+  std::vector<ThreadResult> results(thread_count, {{}, {}, 0, 0});
+  std::vector<std::thread> threads;
+  Clock::time_point start = Clock::now();
+  for (int thread = 0; thread < thread_count; thread++) {
+    threads.emplace_back(RunThread, socket_path, sessions, moves,
+                         thread + 1, &results[thread]);
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  double seconds =
+      std::chrono::duration<double>(Clock::now() - start).count();
+
+  ThreadResult total = {{}, {}, 0, 0};
+  for (auto &result : results) {
+    total.setup_us.insert(total.setup_us.end(), result.setup_us.begin(),
+                          result.setup_us.end());
+    total.move_us.insert(total.move_us.end(), result.move_us.begin(),
+                         result.move_us.end());
+    total.scoring_moves += result.scoring_moves;
+    total.failures += result.failures;
+  }
+
+  double setup_seconds = 0.0;
+  for (double setup : total.setup_us) {
+    setup_seconds += setup / 1000000.0;
+  }
+  std::cout << "sessions " << total.setup_us.size() << " failures "
+            << total.failures << " seconds " << seconds << std::endl;
+  std::cout << "setup " << total.setup_us.size() * thread_count /
+                               std::max(setup_seconds, 1e-9)
+            << " sessions/s p50 " << Percentile(total.setup_us, 0.5)
+            << "us p99 " << Percentile(total.setup_us, 0.99) << "us"
+            << std::endl;
+  std::cout << "moves " << total.move_us.size() << " scoring "
+            << total.scoring_moves << " rate "
+            << total.move_us.size() / seconds << " moves/s p50 "
+            << Percentile(total.move_us, 0.5) << "us p99 "
+            << Percentile(total.move_us, 0.99) << "us max "
+            << Percentile(total.move_us, 1.0) << "us" << std::endl;
+  return 0;
+}
@@ -0,0 +1,62 @@
+#include "protocol.hpp"
+
+void Protocol::Writer::Begin(MessageType type) {
+  _frame_start = _out.size();
+  // the size is filled in by End
+  Put32(0);
+  Put8(type);
+}
+
+void Protocol::Writer::End() {
+  uint32_t payload_size = _out.size() - _frame_start - kHeaderSize;
+  for (int byte = 0; byte < 4; byte++) {
+    _out[_frame_start + byte] = payload_size >> (8 * byte);
+  }
+}
+
+void Protocol::Writer::PutLittleEndian(uint64_t value, int bytes) {
+  for (int byte = 0; byte < bytes; byte++) {
+    _out.push_back(value >> (8 * byte));
+  }
+}
+
+const uint8_t *Protocol::Reader::GetBytes(size_t size) {
+  if (remaining() < size) {
+    _ok = false;
+    _offset = _size;
+    return nullptr;
+  }
+  const uint8_t *bytes = _data + _offset;
+  _offset += size;
+  return bytes;
+}
+
+uint64_t Protocol::Reader::GetLittleEndian(int bytes) {
+  const uint8_t *data = GetBytes(bytes);
+  if (!data) {
+    return 0;
+  }
+  uint64_t value = 0;
+  for (int byte = 0; byte < bytes; byte++) {
+    value |= static_cast<uint64_t>(data[byte]) << (8 * byte);
+  }
+  return value;
+}
+
+long Protocol::ParseFrame(const uint8_t *data, size_t size, MessageType *type,
+                          Reader *payload) {
+  if (size < kHeaderSize) {
+    return 0;
+  }
+  Reader header(data, kHeaderSize);
+  uint32_t payload_size = header.Get32();
+  if (payload_size > kMaxPayloadSize) {
+    return -1;
+  }
+  if (size < kHeaderSize + payload_size) {
+    return 0;
+  }
+  *type = static_cast<MessageType>(header.Get8());
+  *payload = Reader(data + kHeaderSize, payload_size);
+  return kHeaderSize + payload_size;
+}
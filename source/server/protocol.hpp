@@ -0,0 +1,94 @@
+#ifndef SOURCE_SERVER_PROTOCOL_HPP_
+#define SOURCE_SERVER_PROTOCOL_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Binary protocol between the game server and its clients. A frame is a
+// uint32 payload size, a uint8 message type and the payload, all integers
+// are little endian. Boards are column major piece types like GameBoard.
+class Protocol {
+ public:
+  enum MessageType : uint8_t {
+    // client to server
+    // uint64 seed, starts the game and is answered with kBoard
+    kHello = 1,
+    // uint16 x, uint16 y, uint8 Direction, answered with kDelta or kBoard
+    kSwap,
+    // leaves the paused or level complete state, answered with kBoard
+    kContinue,
+    kBye,
+
+    // server to client
+    // Status, uint16 width, uint16 height, width * height uint8 types
+    kBoard = 0x81,
+    // Status, int32 move score, uint32 count, count * (uint32 index, uint8
+    // type) of the tiles that changed since the last board or delta
+    kDelta,
+    // uint8 MessageType of the rejected frame
+    kError,
+  };
+
+  // neighbour to swap with, in the order of the board neighbour offsets
+  enum Direction : uint8_t { kLeft = 0, kDown, kRight, kUp };
+
+  // Status is uint32 score, uint32 goal, uint8 GameLogic::GameState
+  static constexpr size_t kHeaderSize = 5;
+  static constexpr size_t kStatusSize = 9;
+  // larger frames are a protocol error, this fits boards beyond 4096x4096
+  static constexpr uint32_t kMaxPayloadSize = 1 << 25;
+
+  // Appends frames to a byte buffer, Begin and End enclose each payload.
+  class Writer {
+   public:
+    explicit Writer(std::vector<uint8_t> &out) : _out(out), _frame_start(0) {}
+
+    void Begin(MessageType type);
+    void End();
+    void Put8(uint8_t value) { _out.push_back(value); }
+    void Put16(uint16_t value) { PutLittleEndian(value, 2); }
+    void Put32(uint32_t value) { PutLittleEndian(value, 4); }
+    void Put64(uint64_t value) { PutLittleEndian(value, 8); }
+    void PutBytes(const uint8_t *data, size_t size) {
+      _out.insert(_out.end(), data, data + size);
+    }
+
+   private:
+    void PutLittleEndian(uint64_t value, int bytes);
+
+    std::vector<uint8_t> &_out;
+    size_t _frame_start;
+  };
+
+  // Reads a payload, reads past its end return 0 and mark it not ok.
+  class Reader {
+   public:
+    Reader(const uint8_t *data, size_t size)
+        : _data(data), _size(size), _offset(0), _ok(true) {}
+
+    uint8_t Get8() { return GetLittleEndian(1); }
+    uint16_t Get16() { return GetLittleEndian(2); }
+    uint32_t Get32() { return GetLittleEndian(4); }
+    uint64_t Get64() { return GetLittleEndian(8); }
+    const uint8_t *GetBytes(size_t size);
+
+    bool ok() const { return _ok; }
+    size_t remaining() const { return _size - _offset; }
+
+   private:
+    uint64_t GetLittleEndian(int bytes);
+
+    const uint8_t *_data;
+    size_t _size;
+    size_t _offset;
+    bool _ok;
+  };
+
+  // Finds the first frame in data. Returns the frame size, 0 when the frame
+  // is not complete yet and -1 when it is malformed.
+  static long ParseFrame(const uint8_t *data, size_t size, MessageType *type,
+                         Reader *payload);
+};
+
+#endif  // SOURCE_SERVER_PROTOCOL_HPP_
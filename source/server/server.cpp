@@ -0,0 +1,284 @@
+#include "server.hpp"
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+Server::Server(const std::string &socket_path, int shard_count)
+    : _socket_path(socket_path), _listen_fd(-1), _stop_fd(-1) {
+  for (int shard = 0; shard < std::max(shard_count, 1); shard++) {
+    _shards.push_back(std::make_unique<Shard>());
+  }
+}
+
+Server::~Server() {
+  for (auto &shard : _shards) {
+    shard->Stop();
+    shard->Join();
+  }
+  if (_listen_fd >= 0) {
+    close(_listen_fd);
+    unlink(_socket_path.c_str());
+  }
+  if (_stop_fd >= 0) {
+    close(_stop_fd);
+  }
+}
+
+bool Server::Listen() {
+  sockaddr_un address = {};
+  address.sun_family = AF_UNIX;
+  if (_socket_path.size() >= sizeof(address.sun_path)) {
+    std::cerr << "socket path too long: " << _socket_path << std::endl;
+    return false;
+  }
+  std::strcpy(address.sun_path, _socket_path.c_str());
+  // a socket left behind by a previous run would fail the bind
+  unlink(_socket_path.c_str());
+
+  _listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  _stop_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (_listen_fd < 0 || _stop_fd < 0 ||
+      bind(_listen_fd, reinterpret_cast<sockaddr *>(&address),
+           sizeof(address)) != 0 ||
+      listen(_listen_fd, SOMAXCONN) != 0) {
+    std::cerr << "could not listen on " << _socket_path << ": "
+              << std::strerror(errno) << std::endl;
+    return false;
+  }
+
+  for (auto &shard : _shards) {
+    if (!shard->Start()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void Server::Run() {
+  int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  epoll_event event = {};
+  event.events = EPOLLIN;
+  event.data.fd = _listen_fd;
+  epoll_ctl(epoll_fd, EPOLL_CTL_ADD, _listen_fd, &event);
+  event.data.fd = _stop_fd;
+  epoll_ctl(epoll_fd, EPOLL_CTL_ADD, _stop_fd, &event);
+
+  size_t next_shard = 0;
+  bool stopping = false;
+  while (!stopping) {
+    epoll_event ready[2];
+    int count = epoll_wait(epoll_fd, ready, 2, -1);
+    for (int i = 0; i < count; i++) {
+      if (ready[i].data.fd == _stop_fd) {
+        stopping = true;
+        continue;
+      }
+      // accept everything queued, connections go to the shards in turn
+      int fd;
+      while ((fd = accept4(_listen_fd, nullptr, nullptr,
+                           SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+        _shards[next_shard]->Adopt(fd);
+        next_shard = (next_shard + 1) % _shards.size();
+      }
+    }
+  }
+  close(epoll_fd);
+}
+
+void Server::Stop() {
+  uint64_t value = 1;
+  ssize_t written = write(_stop_fd, &value, sizeof(value));
+  (void)written;
+}
+
+Server::Shard::Shard()
+    : _epoll_fd(-1), _wake_fd(-1), _stopping(false), _read_buffer(kReadSize) {}
+
+Server::Shard::~Shard() {
+  for (auto &connection : _connections) {
+    close(connection.first);
+  }
+  if (_epoll_fd >= 0) {
+    close(_epoll_fd);
+  }
+  if (_wake_fd >= 0) {
+    close(_wake_fd);
+  }
+}
+
+bool Server::Shard::Start() {
+  _epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  _wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (_epoll_fd < 0 || _wake_fd < 0) {
+    return false;
+  }
+  epoll_event event = {};
+  event.events = EPOLLIN;
+  event.data.fd = _wake_fd;
+  epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, _wake_fd, &event);
+  _thread = std::thread(&Shard::Loop, this);
+  return true;
+}
+
+void Server::Shard::Join() {
+  if (_thread.joinable()) {
+    _thread.join();
+  }
+}
+
+void Server::Shard::Adopt(int fd) {
+  {
+    std::lock_guard<std::mutex> lock(_pending_mutex);
+    _pending.push_back(fd);
+  }
+  uint64_t value = 1;
+  ssize_t written = write(_wake_fd, &value, sizeof(value));
+  (void)written;
+}
+
+void Server::Shard::Stop() {
+  _stopping = true;
+  uint64_t value = 1;
+  ssize_t written = write(_wake_fd, &value, sizeof(value));
+  (void)written;
+}
+
+void Server::Shard::Loop() {
+  epoll_event events[kMaxEvents];
+  while (!_stopping) {
+    int count = epoll_wait(_epoll_fd, events, kMaxEvents, -1);
+    for (int i = 0; i < count; i++) {
+      int fd = events[i].data.fd;
+      if (fd == _wake_fd) {
+        uint64_t value;
+        ssize_t bytes = read(_wake_fd, &value, sizeof(value));
+        (void)bytes;
+        AdoptPending();
+        continue;
+      }
+
+      auto connection = _connections.find(fd);
+      if (connection == _connections.end()) {
+        continue;
+      }
+      if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+        Read(fd, *connection->second);
+      }
+      if (events[i].events & EPOLLOUT) {
+        Write(fd, *connection->second);
+      }
+      if (connection->second->closing &&
+          connection->second->output_offset ==
+              connection->second->output.size()) {
+        Close(fd);
+      }
+    }
+  }
+}
+
+void Server::Shard::AdoptPending() {
+  std::vector<int> pending;
+  {
+    std::lock_guard<std::mutex> lock(_pending_mutex);
+    pending.swap(_pending);
+  }
+  for (int fd : pending) {
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    if (epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0) {
+      close(fd);
+      continue;
+    }
+    auto connection = std::make_unique<Connection>();
+    connection->output_offset = 0;
+    connection->waiting_writable = false;
+    connection->closing = false;
+    _connections[fd] = std::move(connection);
+  }
+}
+
+void Server::Shard::Read(int fd, Connection &connection) {
+  ssize_t bytes = read(fd, _read_buffer.data(), _read_buffer.size());
+  if (bytes <= 0) {
+    if (bytes == 0 || (errno != EAGAIN && errno != EINTR)) {
+      // the peer is gone, nothing left to write to
+      connection.output_offset = connection.output.size();
+      connection.closing = true;
+    }
+    return;
+  }
+  connection.input.insert(connection.input.end(), _read_buffer.begin(),
+                          _read_buffer.begin() + bytes);
+
+  // handle every complete frame, keep a partial one for the next read
+  size_t offset = 0;
+  while (!connection.closing) {
+    Protocol::MessageType type;
+    Protocol::Reader payload(nullptr, 0);
+    long frame_size =
+        Protocol::ParseFrame(connection.input.data() + offset,
+                             connection.input.size() - offset, &type, &payload);
+    if (frame_size == 0) {
+      break;
+    }
+    if (frame_size < 0 ||
+        !connection.session.Handle(type, payload, connection.output)) {
+      connection.closing = true;
+      break;
+    }
+    offset += frame_size;
+  }
+  connection.input.erase(connection.input.begin(),
+                         connection.input.begin() + offset);
+  Write(fd, connection);
+}
+
+void Server::Shard::Write(int fd, Connection &connection) {
+  while (connection.output_offset < connection.output.size()) {
+    ssize_t bytes =
+        send(fd, connection.output.data() + connection.output_offset,
+             connection.output.size() - connection.output_offset,
+             MSG_NOSIGNAL);
+    if (bytes < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno != EAGAIN) {
+        connection.output_offset = connection.output.size();
+        connection.closing = true;
+      }
+      break;
+    }
+    connection.output_offset += bytes;
+  }
+
+  // only wait for writability while output is pending
+  bool pending = connection.output_offset < connection.output.size();
+  if (!pending) {
+    connection.output.clear();
+    connection.output_offset = 0;
+  }
+  if (pending != connection.waiting_writable) {
+    connection.waiting_writable = pending;
+    epoll_event event = {};
+    event.events = pending ? EPOLLIN | EPOLLOUT : EPOLLIN;
+    event.data.fd = fd;
+    epoll_ctl(_epoll_fd, EPOLL_CTL_MOD, fd, &event);
+  }
+}
+
+void Server::Shard::Close(int fd) {
+  epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+  close(fd);
+  _connections.erase(fd);
+}
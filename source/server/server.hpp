@@ -0,0 +1,78 @@
+#ifndef SOURCE_SERVER_SERVER_HPP_
+#define SOURCE_SERVER_SERVER_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "session.hpp"
+
+// Serves game sessions over a Unix domain socket. Run accepts connections
+// and hands each to one of the shards, a thread with its own epoll loop that
+// owns the sessions of its connections, so sessions are never shared between
+// threads.
+class Server {
+ public:
+  Server(const std::string &socket_path, int shard_count);
+  ~Server();
+
+  bool Listen();
+  // returns once Stop is called, safe to call Stop from a signal handler
+  void Run();
+  void Stop();
+
+ private:
+  typedef struct {
+    Session session;
+    std::vector<uint8_t> input;
+    std::vector<uint8_t> output;
+    // bytes of output already written
+    size_t output_offset;
+    bool waiting_writable;
+    bool closing;
+  } Connection;
+
+  class Shard {
+   public:
+    Shard();
+    ~Shard();
+
+    bool Start();
+    void Join();
+    // hands over a connected socket, called from the accept thread
+    void Adopt(int fd);
+    void Stop();
+
+   private:
+    static constexpr int kMaxEvents = 256;
+    static constexpr size_t kReadSize = 64 * 1024;
+
+    void Loop();
+    void AdoptPending();
+    void Read(int fd, Connection &connection);
+    void Write(int fd, Connection &connection);
+    void Close(int fd);
+
+    int _epoll_fd;
+    // wakes the loop for adopted connections and Stop
+    int _wake_fd;
+    std::atomic<bool> _stopping;
+    std::mutex _pending_mutex;
+    std::vector<int> _pending;
+    std::unordered_map<int, std::unique_ptr<Connection>> _connections;
+    std::vector<uint8_t> _read_buffer;
+    std::thread _thread;
+  };
+
+  std::string _socket_path;
+  int _listen_fd;
+  int _stop_fd;
+  std::vector<std::unique_ptr<Shard>> _shards;
+};
+
+#endif  // SOURCE_SERVER_SERVER_HPP_
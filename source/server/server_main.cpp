@@ -0,0 +1,43 @@
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "server.hpp"
+
+namespace {
+
+Server *running_server = nullptr;
+
+void HandleSignal(int) { running_server->Stop(); }
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  std::string socket_path = "/tmp/tux_match.sock";
+  int shard_count = std::thread::hardware_concurrency();
+  for (int i = 1; i < argc; i += 2) {
+    if (i + 1 < argc && std::strcmp(argv[i], "--socket") == 0) {
+      socket_path = argv[i + 1];
+    } else if (i + 1 < argc && std::strcmp(argv[i], "--threads") == 0) {
+      shard_count = std::atoi(argv[i + 1]);
+    } else {
+      std::cerr << "usage: " << argv[0]
+                << " [--socket path] [--threads count]" << std::endl;
+      return 1;
+    }
+  }
+
+  Server server(socket_path, shard_count);
+  if (!server.Listen()) {
+    return 1;
+  }
+  running_server = &server;
+  std::signal(SIGINT, HandleSignal);
+  std::signal(SIGTERM, HandleSignal);
+  std::cout << "serving on " << socket_path << std::endl;
+  server.Run();
+  return 0;
+}
@@ -0,0 +1,156 @@
+#include "session.hpp"
+
+#include <array>
+
+Session::Session() : _sent_width(0), _sent_height(0) {}
+
+Session::~Session() {}
+
+bool Session::Handle(Protocol::MessageType type, Protocol::Reader &payload,
+                     std::vector<uint8_t> &out) {
+  if (type == Protocol::kBye) {
+    return false;
+  }
+  if (type == Protocol::kHello && !_logic) {
+    uint64_t seed = payload.Get64();
+    if (payload.ok()) {
+      _logic = std::make_unique<GameLogic>(seed);
+      // sessions start playing right away, unlike the window
+      _logic->MouseRelease(0.0f, 0.0f);
+      WriteBoard(out);
+      return true;
+    }
+  } else if (type == Protocol::kSwap && _logic) {
+    if (Swap(payload, out)) {
+      return true;
+    }
+  } else if (type == Protocol::kContinue && _logic) {
+    Continue(out);
+    return true;
+  }
+  WriteError(type, out);
+  return true;
+}
+
+bool Session::Swap(Protocol::Reader &payload, std::vector<uint8_t> &out) {
+  int x = payload.Get16();
+  int y = payload.Get16();
+  int direction = payload.Get8();
+  if (!payload.ok() || x >= _logic->width() || y >= _logic->height() ||
+      direction > Protocol::kUp) {
+    return false;
+  }
+
+  // a drag from the tile center to the neighbour center, see GameBoard
+  static constexpr std::array<std::array<int, 2>, 4> kSteps = {
+      {{-1, 0}, {0, -1}, {1, 0}, {0, 1}}};
+  float start_x = x + 0.5f;
+  float start_y = y + 0.5f;
+  int score = _logic->score();
+  _logic->MouseClick(start_x, start_y);
+  _logic->MouseRelease(start_x + kSteps[direction][0],
+                       start_y + kSteps[direction][1]);
+  Settle();
+
+  int move_score = _logic->score() - score;
+  if (_logic->width() != _sent_width || _logic->height() != _sent_height) {
+    WriteBoard(out);
+  } else {
+    WriteDelta(move_score, out);
+  }
+  return true;
+}
+
+void Session::Continue(std::vector<uint8_t> &out) {
+  if (_logic->state() != GameLogic::kPlaying) {
+    _logic->MouseRelease(0.0f, 0.0f);
+  }
+  WriteBoard(out);
+}
+
+void Session::Settle() {
+  for (int tick = 0; tick < kMaxSettleTicks && Deleting(); tick++) {
+    _logic->PhysicsTick();
+  }
+}
+
+bool Session::Deleting() const {
+  const GameBoard &board = _logic->board();
+  for (int x = 0; x < board.width(); x++) {
+    const GameBoard::BoardTile *column = board.column(x);
+    for (int y = 0; y < board.height(); y++) {
+      GameBoard::Animation animation = column[y].animation();
+      if (animation == GameBoard::kDelete ||
+          animation == GameBoard::kDeleteDone) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+void Session::WriteStatus(Protocol::Writer &writer) const {
+  writer.Put32(_logic->score());
+  writer.Put32(_logic->goal());
+  writer.Put8(_logic->state());
+}
+
+void Session::WriteBoard(std::vector<uint8_t> &out) {
+  const GameBoard &board = _logic->board();
+  _sent_width = board.width();
+  _sent_height = board.height();
+  _sent_types.resize(_sent_width * _sent_height);
+  auto type = _sent_types.begin();
+  for (int x = 0; x < _sent_width; x++) {
+    const GameBoard::BoardTile *column = board.column(x);
+    for (int y = 0; y < _sent_height; y++) {
+      *type++ = column[y].type();
+    }
+  }
+
+  Protocol::Writer writer(out);
+  writer.Begin(Protocol::kBoard);
+  WriteStatus(writer);
+  writer.Put16(_sent_width);
+  writer.Put16(_sent_height);
+  writer.PutBytes(_sent_types.data(), _sent_types.size());
+  writer.End();
+}
+
+void Session::WriteDelta(int move_score, std::vector<uint8_t> &out) {
+  Protocol::Writer writer(out);
+  writer.Begin(Protocol::kDelta);
+  WriteStatus(writer);
+  writer.Put32(move_score);
+  // the count is patched once the changes are known
+  size_t count_offset = out.size();
+  writer.Put32(0);
+
+  const GameBoard &board = _logic->board();
+  uint32_t count = 0;
+  int index = 0;
+  for (int x = 0; x < _sent_width; x++) {
+    const GameBoard::BoardTile *column = board.column(x);
+    for (int y = 0; y < _sent_height; y++, index++) {
+      uint8_t type = column[y].type();
+      if (type != _sent_types[index]) {
+        _sent_types[index] = type;
+        writer.Put32(index);
+        writer.Put8(type);
+        count++;
+      }
+    }
+  }
+  for (int byte = 0; byte < 4; byte++) {
+    out[count_offset + byte] = count >> (8 * byte);
+  }
+  writer.End();
+}
+
+void Session::WriteError(Protocol::MessageType type,
+                         std::vector<uint8_t> &out) {
+  Protocol::Writer writer(out);
+  writer.Begin(Protocol::kError);
+  writer.Put8(type);
+  writer.End();
+}
@@ -0,0 +1,44 @@
+#ifndef SOURCE_SERVER_SESSION_HPP_
+#define SOURCE_SERVER_SESSION_HPP_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "game_logic/game_logic.hpp"
+#include "protocol.hpp"
+
+// One game played over the protocol. Moves are played out until their
+// deletions are replenished, so every reply holds the settled board.
+class Session {
+ public:
+  Session();
+  ~Session();
+
+  // Handles a client frame and appends the replies to out, returns false
+  // when the session ends.
+  bool Handle(Protocol::MessageType type, Protocol::Reader &payload,
+              std::vector<uint8_t> &out);
+
+ private:
+  // enough for the delete animation and the replenish
+  static constexpr int kMaxSettleTicks = 64;
+
+  bool Swap(Protocol::Reader &payload, std::vector<uint8_t> &out);
+  void Continue(std::vector<uint8_t> &out);
+  void Settle();
+  bool Deleting() const;
+  void WriteStatus(Protocol::Writer &writer) const;
+  void WriteBoard(std::vector<uint8_t> &out);
+  void WriteDelta(int move_score, std::vector<uint8_t> &out);
+  static void WriteError(Protocol::MessageType type,
+                         std::vector<uint8_t> &out);
+
+  std::unique_ptr<GameLogic> _logic;
+  // column major types as last sent to the client
+  std::vector<uint8_t> _sent_types;
+  int _sent_width;
+  int _sent_height;
+};
+
+#endif  // SOURCE_SERVER_SESSION_HPP_
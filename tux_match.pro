@@ -6,6 +6,12 @@ TARGET = tux_match
 TEMPLATE = app
 CONFIG += c++1z debug
 
+# CONFIG += count_allocations reports heap allocations per frame
+count_allocations: DEFINES += TUX_MATCH_COUNT_ALLOCATIONS
+
+# shm_open, see StatePublisher
+linux:!android: LIBS += -lrt
+
 # add include dirs
 INCLUDEPATH += source
 # Link and include the application source files
@@ -13,14 +19,53 @@ SOURCES += \
         source/main.cpp \
         source/graphics_engine/graphics_engine.cpp \
         source/graphics_engine/board_renderer.cpp \
+        source/graphics_engine/board_resources.cpp \
+        source/graphics_engine/camera.cpp \
+        source/graphics_engine/layer_cache.cpp \
+        source/graphics_engine/input_queue.cpp \
+        source/graphics_engine/asset_loader.cpp \
+        source/graphics_engine/render_queue.cpp \
+        source/graphics_engine/quality_governor.cpp \
+        source/graphics_engine/particle_system.cpp \
         source/game_logic/game_logic.cpp \
-        source/game_logic/game_board.cpp
+        source/game_logic/game_board.cpp \
+        source/game_logic/blob_labeler.cpp \
+        source/game_logic/worker_pool.cpp \
+        source/game_logic/move_speculator.cpp \
+        source/game_logic/move_journal.cpp \
+        source/game_logic/random_source.cpp \
+        source/game_logic/board_generator.cpp \
+        source/game_logic/frame_arena.cpp \
+        source/game_logic/state_publisher.cpp \
+        source/game_logic/timing_wheel.cpp \
+        source/game_logic/level_pack.cpp \
+        source/game_logic/goal_calibrator.cpp
 
 HEADERS += \
         source/graphics_engine/graphics_engine.hpp \
         source/graphics_engine/board_renderer.hpp \
+        source/graphics_engine/board_resources.hpp \
+        source/graphics_engine/camera.hpp \
+        source/graphics_engine/layer_cache.hpp \
+        source/graphics_engine/input_queue.hpp \
+        source/graphics_engine/asset_loader.hpp \
+        source/graphics_engine/render_queue.hpp \
+        source/graphics_engine/quality_governor.hpp \
+        source/graphics_engine/particle_system.hpp \
         source/game_logic/game_logic.hpp \
         source/game_logic/game_board.hpp \
+        source/game_logic/blob_labeler.hpp \
+        source/game_logic/worker_pool.hpp \
+        source/game_logic/move_speculator.hpp \
+        source/game_logic/move_journal.hpp \
+        source/game_logic/random_source.hpp \
+        source/game_logic/board_generator.hpp \
+        source/game_logic/board_dims.hpp \
+        source/game_logic/frame_arena.hpp \
+        source/game_logic/state_publisher.hpp \
+        source/game_logic/timing_wheel.hpp \
+        source/game_logic/level_pack.hpp \
+        source/game_logic/goal_calibrator.hpp \
         source/game_logic/coordinates.hpp
 
 RESOURCES += \